@@ -1,5 +1,30 @@
 ﻿#include <iostream>
 #include <string>
+#include <vector>
+#include <span>
+#include <random>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define COMBAT_X86 1
+#define COMBAT_TARGET(isa) __attribute__((target(isa)))
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <immintrin.h>
+#include <intrin.h>
+#define COMBAT_X86 1
+#define COMBAT_TARGET(isa)
+#endif
+
+// Особый эффект атаки: если бросок (0..99) меньше chance, урон умножается на multiplier и растёт на bonus
+struct Proc {
+    int chance;
+    int multiplier;
+    int bonus;
+};
 
 class Character {
 private:
@@ -7,12 +32,14 @@ private:
     int health;        // Приватное поле: уровень здоровья
     int attack;        // Приватное поле: уровень атаки
     int defense;       // Приватное поле: уровень защиты
-    static const int MAX_HEALTH = 100; // Максимальное значение здоровья
+    Proc proc;         // Приватное поле: особый эффект атаки (по умолчанию нет)
 
 public:
+    static const int MAX_HEALTH = 100; // Максимальное значение здоровья
+
     // Конструктор для инициализации данных
-    Character(const std::string& n, int h, int a, int d)
-        : name(n), health(h), attack(a), defense(d) {
+    Character(const std::string& n, int h, int a, int d, Proc p = { 0, 1, 0 })
+        : name(n), health(h), attack(a), defense(d), proc(p) {
     }
 
     // Метод для получения уровня здоровья
@@ -26,11 +53,23 @@ public:
             << ", Attack: " << attack << ", Defense: " << defense << std::endl;
     }
 
-    // Метод для атаки другого персонажа
-    void attackEnemy(Character& enemy) {
+    // Удар без вывода: roll - бросок 0..99 для особого эффекта. Возвращает нанесённый урон.
+    int strike(Character& enemy, int roll) {
         int damage = attack - enemy.defense;
+        if (damage <= 0) {
+            return 0;
+        }
+        if (roll < proc.chance) {
+            damage = damage * proc.multiplier + proc.bonus;
+        }
+        enemy.takeDamage(damage);
+        return damage > 0 ? damage : 0;
+    }
+
+    // Метод для атаки другого персонажа
+    void attackEnemy(Character& enemy, int roll = 100) {
+        int damage = strike(enemy, roll);
         if (damage > 0) {
-            enemy.takeDamage(damage);
             std::cout << name << " attacks " << enemy.name << " for " << damage << " damage!" << std::endl;
         }
         else {
@@ -60,7 +99,394 @@ public:
     }
 };
 
-int main() {
+// ==== Массовый бой ====
+// Характеристики отряда хранятся структурой массивов, чтобы удары по тысячам пар
+// считались векторными командами. Правила те же, что у Character::strike/heal.
+
+// Представление отряда (или его части): по одному элементу каждого массива на бойца
+struct SquadSpan {
+    std::span<int> health;
+    std::span<const int> attack;
+    std::span<const int> defense;
+    std::span<const int> procChance;
+    std::span<const int> procMultiplier;
+    std::span<const int> procBonus;
+    std::span<std::uint8_t> dead;  // 1, если здоровье <= 0
+
+    size_t size() const { return health.size(); }
+};
+
+struct Squad {
+    std::vector<int> health;
+    std::vector<int> attack;
+    std::vector<int> defense;
+    std::vector<int> procChance;
+    std::vector<int> procMultiplier;
+    std::vector<int> procBonus;
+    std::vector<std::uint8_t> dead;
+
+    void add(int h, int a, int d, Proc p = { 0, 1, 0 }) {
+        health.push_back(h);
+        attack.push_back(a);
+        defense.push_back(d);
+        procChance.push_back(p.chance);
+        procMultiplier.push_back(p.multiplier);
+        procBonus.push_back(p.bonus);
+        dead.push_back(h <= 0);
+    }
+
+    size_t size() const { return health.size(); }
+
+    SquadSpan view(size_t first, size_t count) {
+        return { std::span<int>(health).subspan(first, count),
+            std::span<const int>(attack).subspan(first, count),
+            std::span<const int>(defense).subspan(first, count),
+            std::span<const int>(procChance).subspan(first, count),
+            std::span<const int>(procMultiplier).subspan(first, count),
+            std::span<const int>(procBonus).subspan(first, count),
+            std::span<std::uint8_t>(dead).subspan(first, count) };
+    }
+
+    SquadSpan view() { return view(0, size()); }
+};
+
+enum class Kernel {
+    Scalar,
+    Sse41,
+    Avx2
+};
+
+const char* kernelName(Kernel kernel) {
+    switch (kernel) {
+    case Kernel::Sse41: return "sse4.1";
+    case Kernel::Avx2: return "avx2";
+    default: return "scalar";
+    }
+}
+
+bool kernelSupported(Kernel kernel) {
+    if (kernel == Kernel::Scalar) return true;
+#if defined(COMBAT_X86) && defined(__GNUC__)
+    __builtin_cpu_init();
+    return kernel == Kernel::Sse41 ? __builtin_cpu_supports("sse4.1") : __builtin_cpu_supports("avx2");
+#elif defined(COMBAT_X86)
+    int info[4];
+    __cpuid(info, 1);
+    bool sse41 = (info[2] & (1 << 19)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0 && (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 6) == 6;
+    __cpuidex(info, 7, 0);
+    bool avx2 = avx && (info[1] & (1 << 5)) != 0;
+    return kernel == Kernel::Sse41 ? sse41 : avx2;
+#else
+    return false;
+#endif
+}
+
+Kernel bestKernel() {
+    static const Kernel best = kernelSupported(Kernel::Avx2) ? Kernel::Avx2
+        : kernelSupported(Kernel::Sse41) ? Kernel::Sse41 : Kernel::Scalar;
+    return best;
+}
+
+// Скалярные правила - то же, что Character::strike и Character::takeDamage
+inline int resolveDamage(int attack, int defense, int roll, int chance, int multiplier, int bonus) {
+    int damage = attack - defense;
+    if (damage <= 0) return 0;
+    if (roll < chance) damage = damage * multiplier + bonus;
+    return damage > 0 ? damage : 0;
+}
+
+void resolveScalar(const SquadSpan& attackers, const SquadSpan& targets, const int* rolls, int* damage, size_t first) {
+    for (size_t i = first; i < targets.size(); ++i) {
+        int d = resolveDamage(attackers.attack[i], targets.defense[i], rolls[i],
+            attackers.procChance[i], attackers.procMultiplier[i], attackers.procBonus[i]);
+        int h = targets.health[i];
+        if (d > 0) {
+            h -= d;
+            if (h < 0) h = 0;
+        }
+        targets.health[i] = h;
+        targets.dead[i] = h <= 0;
+        damage[i] = d;
+    }
+}
+
+void healScalar(const SquadSpan& targets, const int* amounts, size_t first) {
+    for (size_t i = first; i < targets.size(); ++i) {
+        int h = targets.health[i];
+        if (amounts[i] > 0) {
+            h += amounts[i];
+            if (h > Character::MAX_HEALTH) h = Character::MAX_HEALTH;
+        }
+        targets.health[i] = h;
+        targets.dead[i] = h <= 0;
+    }
+}
+
+#ifdef COMBAT_X86
+COMBAT_TARGET("sse4.1")
+inline __m128i load4(const int* p, size_t i) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+}
+
+// Маска (0 / -1 в каждом 32-битном элементе) -> четыре байта 0 / 1
+COMBAT_TARGET("sse4.1")
+inline void storeFlags4(std::uint8_t* out, __m128i mask) {
+    __m128i bytes = _mm_packs_epi16(_mm_packs_epi32(mask, mask), mask);
+    std::uint32_t word = static_cast<std::uint32_t>(_mm_cvtsi128_si32(bytes)) & 0x01010101u;
+    std::memcpy(out, &word, 4);
+}
+
+COMBAT_TARGET("sse4.1")
+size_t resolveSse41(const SquadSpan& attackers, const SquadSpan& targets, const int* rolls, int* damage) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi32(1);
+    size_t i = 0;
+    for (; i + 4 <= targets.size(); i += 4) {
+        __m128i d = _mm_sub_epi32(load4(attackers.attack.data(), i), load4(targets.defense.data(), i));
+        __m128i hit = _mm_cmpgt_epi32(d, zero);
+        __m128i procs = _mm_and_si128(hit, _mm_cmplt_epi32(load4(rolls, i), load4(attackers.procChance.data(), i)));
+        __m128i boosted = _mm_add_epi32(_mm_mullo_epi32(d, load4(attackers.procMultiplier.data(), i)), load4(attackers.procBonus.data(), i));
+        d = _mm_max_epi32(_mm_blendv_epi8(d, boosted, procs), zero);
+
+        __m128i h = load4(targets.health.data(), i);
+        h = _mm_blendv_epi8(h, _mm_max_epi32(_mm_sub_epi32(h, d), zero), _mm_cmpgt_epi32(d, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(targets.health.data() + i), h);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(damage + i), d);
+        storeFlags4(targets.dead.data() + i, _mm_cmplt_epi32(h, one));
+    }
+    return i;
+}
+
+COMBAT_TARGET("sse4.1")
+size_t healSse41(const SquadSpan& targets, const int* amounts) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi32(1);
+    const __m128i cap = _mm_set1_epi32(Character::MAX_HEALTH);
+    size_t i = 0;
+    for (; i + 4 <= targets.size(); i += 4) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(amounts + i));
+        __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(targets.health.data() + i));
+        h = _mm_blendv_epi8(h, _mm_min_epi32(_mm_add_epi32(h, a), cap), _mm_cmpgt_epi32(a, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(targets.health.data() + i), h);
+        storeFlags4(targets.dead.data() + i, _mm_cmplt_epi32(h, one));
+    }
+    return i;
+}
+
+COMBAT_TARGET("avx2")
+inline __m256i load8(const int* p, size_t i) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+}
+
+// Маска -> восемь байтов 0 / 1; упаковка идёт внутри 128-битных половин
+COMBAT_TARGET("avx2")
+inline void storeFlags8(std::uint8_t* out, __m256i mask) {
+    __m256i bytes = _mm256_packs_epi16(_mm256_packs_epi32(mask, mask), mask);
+    std::uint32_t low = static_cast<std::uint32_t>(_mm_cvtsi128_si32(_mm256_castsi256_si128(bytes))) & 0x01010101u;
+    std::uint32_t high = static_cast<std::uint32_t>(_mm_cvtsi128_si32(_mm256_extracti128_si256(bytes, 1))) & 0x01010101u;
+    std::memcpy(out, &low, 4);
+    std::memcpy(out + 4, &high, 4);
+}
+
+COMBAT_TARGET("avx2")
+size_t resolveAvx2(const SquadSpan& attackers, const SquadSpan& targets, const int* rolls, int* damage) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi32(1);
+    size_t i = 0;
+    for (; i + 8 <= targets.size(); i += 8) {
+        __m256i d = _mm256_sub_epi32(load8(attackers.attack.data(), i), load8(targets.defense.data(), i));
+        __m256i hit = _mm256_cmpgt_epi32(d, zero);
+        __m256i procs = _mm256_and_si256(hit, _mm256_cmpgt_epi32(load8(attackers.procChance.data(), i), load8(rolls, i)));
+        __m256i boosted = _mm256_add_epi32(_mm256_mullo_epi32(d, load8(attackers.procMultiplier.data(), i)), load8(attackers.procBonus.data(), i));
+        d = _mm256_max_epi32(_mm256_blendv_epi8(d, boosted, procs), zero);
+
+        __m256i h = load8(targets.health.data(), i);
+        h = _mm256_blendv_epi8(h, _mm256_max_epi32(_mm256_sub_epi32(h, d), zero), _mm256_cmpgt_epi32(d, zero));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(targets.health.data() + i), h);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(damage + i), d);
+        storeFlags8(targets.dead.data() + i, _mm256_cmpgt_epi32(one, h));
+    }
+    return i;
+}
+
+COMBAT_TARGET("avx2")
+size_t healAvx2(const SquadSpan& targets, const int* amounts) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i cap = _mm256_set1_epi32(Character::MAX_HEALTH);
+    size_t i = 0;
+    for (; i + 8 <= targets.size(); i += 8) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(amounts + i));
+        __m256i h = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(targets.health.data() + i));
+        h = _mm256_blendv_epi8(h, _mm256_min_epi32(_mm256_add_epi32(h, a), cap), _mm256_cmpgt_epi32(a, zero));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(targets.health.data() + i), h);
+        storeFlags8(targets.dead.data() + i, _mm256_cmpgt_epi32(one, h));
+    }
+    return i;
+}
+#endif
+
+// attackers[i] бьёт targets[i]: здоровье цели уменьшается, флаги смерти обновляются,
+// нанесённый урон пишется в damage[i]. rolls[i] - бросок 0..99 для особого эффекта.
+void resolveAttacks(const SquadSpan& attackers, const SquadSpan& targets, std::span<const int> rolls,
+    std::span<int> damage, Kernel kernel = bestKernel()) {
+    size_t n = targets.size();
+    if (attackers.size() != n || targets.defense.size() != n || targets.dead.size() != n
+        || attackers.attack.size() != n || attackers.procChance.size() != n
+        || attackers.procMultiplier.size() != n || attackers.procBonus.size() != n
+        || rolls.size() != n || damage.size() != n) {
+        throw std::invalid_argument("resolveAttacks: span sizes differ");
+    }
+    if (!kernelSupported(kernel)) {
+        throw std::invalid_argument(std::string("resolveAttacks: ") + kernelName(kernel) + " is not supported");
+    }
+
+    size_t done = 0;
+#ifdef COMBAT_X86
+    if (kernel == Kernel::Avx2) done = resolveAvx2(attackers, targets, rolls.data(), damage.data());
+    else if (kernel == Kernel::Sse41) done = resolveSse41(attackers, targets, rolls.data(), damage.data());
+#endif
+    resolveScalar(attackers, targets, rolls.data(), damage.data(), done);
+}
+
+// Лечение targets[i] на amounts[i] с ограничением MAX_HEALTH, как Character::heal
+void healAll(const SquadSpan& targets, std::span<const int> amounts, Kernel kernel = bestKernel()) {
+    size_t n = targets.size();
+    if (amounts.size() != n || targets.dead.size() != n) {
+        throw std::invalid_argument("healAll: span sizes differ");
+    }
+    if (!kernelSupported(kernel)) {
+        throw std::invalid_argument(std::string("healAll: ") + kernelName(kernel) + " is not supported");
+    }
+
+    size_t done = 0;
+#ifdef COMBAT_X86
+    if (kernel == Kernel::Avx2) done = healAvx2(targets, amounts.data());
+    else if (kernel == Kernel::Sse41) done = healSse41(targets, amounts.data());
+#endif
+    healScalar(targets, amounts.data(), done);
+}
+
+// Проверка свойств: на случайных отрядах каждое ядро даёт ровно то же, что методы Character.
+// Длины и смещения случайные, чтобы проверить и хвосты, и невыровненные адреса.
+bool selfTest(int cases, unsigned seed) {
+    std::mt19937 gen(seed);
+    auto uniform = [&](int lo, int hi) { return std::uniform_int_distribution<int>(lo, hi)(gen); };
+    std::vector<Kernel> kernels;
+    for (Kernel k : { Kernel::Scalar, Kernel::Sse41, Kernel::Avx2 }) {
+        if (kernelSupported(k)) kernels.push_back(k);
+    }
+
+    std::streambuf* output = std::cout.rdbuf(nullptr);  // heal печатает сообщения
+    int failures = 0;
+    for (int c = 0; c < cases && failures < 10; ++c) {
+        size_t offset = uniform(0, 7);
+        size_t n = uniform(0, 70);
+        Squad attackers, targets;
+        std::vector<Character> heroes, enemies;
+        std::vector<int> rolls(offset + n), amounts(offset + n);
+        for (size_t i = 0; i < offset + n; ++i) {
+            Proc p{ uniform(0, 100), uniform(0, 4), uniform(-20, 20) };
+            int a = uniform(-10, 150);
+            attackers.add(uniform(-10, 150), a, uniform(-10, 100), p);
+            heroes.emplace_back("A", attackers.health.back(), a, attackers.defense.back(), p);
+            int h = uniform(-20, 150);
+            int d = uniform(-10, 100);
+            targets.add(h, uniform(-10, 150), d);
+            enemies.emplace_back("T", h, targets.attack.back(), d);
+            rolls[i] = uniform(0, 99);
+            amounts[i] = uniform(-30, 80);
+        }
+
+        std::vector<int> expectedDamage(n), expectedHealth(n), expectedHealed(n);
+        for (size_t i = 0; i < n; ++i) {
+            expectedDamage[i] = heroes[offset + i].strike(enemies[offset + i], rolls[offset + i]);
+            expectedHealth[i] = enemies[offset + i].getHealth();
+            enemies[offset + i].heal(amounts[offset + i]);
+            expectedHealed[i] = enemies[offset + i].getHealth();
+        }
+
+        for (Kernel k : kernels) {
+            Squad t = targets;
+            std::vector<int> damage(n);
+            SquadSpan view = t.view(offset, n);
+            resolveAttacks(attackers.view(offset, n), view, std::span<const int>(rolls).subspan(offset, n), damage, k);
+            bool ok = true;
+            for (size_t i = 0; i < n; ++i) {
+                ok = ok && damage[i] == expectedDamage[i] && view.health[i] == expectedHealth[i]
+                    && view.dead[i] == (expectedHealth[i] <= 0);
+            }
+            healAll(view, std::span<const int>(amounts).subspan(offset, n), k);
+            for (size_t i = 0; i < n; ++i) {
+                ok = ok && view.health[i] == expectedHealed[i] && view.dead[i] == (expectedHealed[i] <= 0);
+            }
+            for (size_t i = 0; i < offset; ++i) {
+                ok = ok && t.health[i] == targets.health[i] && t.dead[i] == targets.dead[i];
+            }
+            if (!ok) {
+                std::cerr << "mismatch: case " << c << ", kernel " << kernelName(k) << ", n " << n << ", offset " << offset << std::endl;
+                ++failures;
+            }
+        }
+    }
+    std::cout.rdbuf(output);
+
+    std::cout << "kernels:";
+    for (Kernel k : kernels) std::cout << " " << kernelName(k);
+    std::cout << "\n" << cases << " cases, " << failures << " failures" << std::endl;
+    return failures == 0;
+}
+
+// Пропускная способность: удары по объектам Character против каждого ядра на тех же данных
+void benchmarkResolve(size_t count) {
+    std::mt19937 gen(1);
+    auto uniform = [&](int lo, int hi) { return std::uniform_int_distribution<int>(lo, hi)(gen); };
+    Squad attackers, targets;
+    std::vector<Character> heroes, enemies;
+    std::vector<int> rolls(count), damage(count);
+    heroes.reserve(count);
+    enemies.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        Proc p{ 20, 2, 0 };
+        int a = uniform(5, 40);
+        attackers.add(100, a, 10, p);
+        heroes.emplace_back("Hero", 100, a, 10, p);
+        int d = uniform(0, 30);
+        targets.add(100, 15, d);
+        enemies.emplace_back("Goblin", 100, 15, d);
+        rolls[i] = uniform(0, 99);
+    }
+
+    const int rounds = 10;
+    auto report = [&](const char* label, auto&& round) {
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < rounds; ++r) round();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << label << ": " << seconds * 1e9 / (static_cast<double>(count) * rounds) << " ns per hit" << std::endl;
+    };
+
+    report("objects", [&] {
+        for (size_t i = 0; i < count; ++i) damage[i] = heroes[i].strike(enemies[i], rolls[i]);
+    });
+    for (Kernel k : { Kernel::Scalar, Kernel::Sse41, Kernel::Avx2 }) {
+        if (!kernelSupported(k)) continue;
+        Squad t = targets;
+        report(kernelName(k), [&] { resolveAttacks(attackers.view(), t.view(), rolls, damage, k); });
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string(argv[1]) == "--selftest") {
+        int cases = argc > 2 ? std::stoi(argv[2]) : 10000;
+        unsigned seed = argc > 3 ? static_cast<unsigned>(std::stoul(argv[3])) : 1;
+        return selfTest(cases, seed) ? 0 : 1;
+    }
+    if (argc > 2 && std::string(argv[1]) == "--bench" && std::string(argv[2]) == "resolve") {
+        benchmarkResolve(argc > 3 ? std::stoull(argv[3]) : 1000000);
+        return 0;
+    }
+
     // Создаем объекты персонажей
     Character hero("Hero", 90, 20, 10);
     Character monster("Goblin", 50, 15, 5);
@@ -86,4 +512,4 @@ int main() {
     hero.displayInfo();
 
     return 0;
-}
\ No newline at end of file
+}
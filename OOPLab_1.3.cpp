@@ -2,139 +2,897 @@
 #include <string>
 #include <cstdlib>
 #include <ctime>
+#include <cstdint>
+#include <charconv>
+#include <cmath>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+#include <stdexcept>
 
-class Entity {
-protected:
-    std::string name;
-    int health;
-    int attackPower;
-    int defense;
+// ==== Случайные числа ====
+
+// Равномерно на [0, n) без смещения: умножение со сдвигом и отбрасывание хвоста (Лемир).
+// next32() - источник равномерных 32-битных чисел.
+template <typename Next>
+std::uint32_t lemireBelow(std::uint32_t n, Next&& next32) {
+    std::uint64_t m = static_cast<std::uint64_t>(next32()) * n;
+    auto low = static_cast<std::uint32_t>(m);
+    if (low < n) {
+        std::uint32_t threshold = static_cast<std::uint32_t>(-n) % n;
+        while (low < threshold) {
+            m = static_cast<std::uint64_t>(next32()) * n;
+            low = static_cast<std::uint32_t>(m);
+        }
+    }
+    return static_cast<std::uint32_t>(m >> 32);
+}
+
+inline std::uint64_t splitMix64(std::uint64_t& state) {
+    std::uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// xoshiro256**: 256 бит состояния, период 2^256 - 1.
+// jump() сдвигает поток на 2^128 чисел - так из одного зерна получаются
+// непересекающиеся потоки для разных потоков выполнения.
+class Xoshiro256 {
+private:
+    std::uint64_t s[4];
+
+    static std::uint64_t rotl(std::uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
 
 public:
-    Entity(const std::string& n, int h, int a, int d)
-        : name(n), health(h), attackPower(a), defense(d) {
+    explicit Xoshiro256(std::uint64_t seed = 1) {
+        for (auto& word : s) word = splitMix64(seed);
     }
 
-    virtual void attack(Entity& target) {
-        int damage = attackPower - target.getDefense();
-        if (damage > 0) {
-            target.reduceHealth(damage);
-            std::cout << name << " attacks " << target.getName() << " for " << damage << " damage!\n";
+    std::uint64_t next() {
+        std::uint64_t result = rotl(s[1] * 5, 7) * 9;
+        std::uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+
+    void jump() {
+        static constexpr std::uint64_t JUMP[] = {
+            0x180EC6D33CFD0ABAull, 0xD5A61266F0C9392Cull, 0xA9582618E03FC9AAull, 0x39ABDC4529B1661Cull
+        };
+        std::uint64_t t[4] = {};
+        for (std::uint64_t word : JUMP) {
+            for (int b = 0; b < 64; ++b) {
+                if (word & (1ull << b)) {
+                    for (int i = 0; i < 4; ++i) t[i] ^= s[i];
+                }
+                next();
+            }
+        }
+        for (int i = 0; i < 4; ++i) s[i] = t[i];
+    }
+
+    unsigned below(unsigned n) {
+        return lemireBelow(n, [this] { return static_cast<std::uint32_t>(next() >> 32); });
+    }
+
+    // count чисел из [0, n) подряд в out - без проверки n на каждом вызове
+    void fill(unsigned* out, size_t count, unsigned n) {
+        std::uint32_t threshold = static_cast<std::uint32_t>(-n) % n;
+        for (size_t i = 0; i < count; ++i) {
+            std::uint64_t m;
+            do {
+                m = (next() >> 32) * n;
+            } while (static_cast<std::uint32_t>(m) < threshold);
+            out[i] = static_cast<unsigned>(m >> 32);
+        }
+    }
+};
+
+// Зерно и счётчик потоков для threadRng(); seedThreadRngs действует на потоки,
+// которые ещё не обращались к генератору
+inline std::atomic<std::uint64_t> threadRngSeed{ 0x5EEDu };
+inline std::atomic<unsigned> threadRngCount{ 0 };
+
+inline void seedThreadRngs(std::uint64_t seed) {
+    threadRngSeed.store(seed, std::memory_order_relaxed);
+}
+
+// Генератор текущего потока: k-й поток получает поток зерна, сдвинутый на k прыжков
+inline Xoshiro256& threadRng() {
+    thread_local Xoshiro256 rng = [] {
+        Xoshiro256 engine(threadRngSeed.load(std::memory_order_relaxed));
+        unsigned index = threadRngCount.fetch_add(1, std::memory_order_relaxed);
+        for (unsigned i = 0; i < index; ++i) engine.jump();
+        return engine;
+    }();
+    return rng;
+}
+
+// Генератор на основе libc rand(), как в исходной игре; оставлен для сравнения
+struct LibcRng {
+    unsigned below(unsigned n) { return static_cast<unsigned>(rand()) % n; }
+};
+
+// Особый эффект атаки: с вероятностью chance% урон умножается на multiplier и растёт на bonus
+struct Proc {
+    int chance;
+    int multiplier;
+    int bonus;
+    const char* message;
+};
+
+// ==== Хранилище сущностей (ECS) ====
+
+// Вид сущности; задаёт особый эффект атаки, общий для всего архетипа
+enum class Kind : std::uint8_t {
+    Entity,
+    Character,
+    Monster,
+    Boss
+};
+
+constexpr Proc procFor(Kind kind) {
+    switch (kind) {
+    case Kind::Character: return { 20, 2, 0, "Critical hit! " };      // двойной урон с шансом 20%
+    case Kind::Monster: return { 30, 1, 5, "Poisonous attack! " };    // +5 урона с шансом 30%
+    case Kind::Boss: return { 40, 1, 10, "Flaming strike! " };        // +10 урона с шансом 40%
+    default: return { 0, 1, 0, "" };
+    }
+}
+
+// Компоненты - биты маски архетипа
+enum Component : std::uint32_t {
+    NameComponent = 1 << 0,
+    HealthComponent = 1 << 1,
+    AttackComponent = 1 << 2,
+    DefenseComponent = 1 << 3,
+    ProgressComponent = 1 << 4
+};
+
+constexpr std::uint32_t COMBATANT = NameComponent | HealthComponent | AttackComponent | DefenseComponent;
+
+struct Progress {
+    int level;
+    int experience;
+};
+
+struct EntityId {
+    std::uint32_t index;
+    std::uint32_t generation;
+};
+
+// Сущности с одинаковым видом и набором компонентов; каждый компонент - плотный массив,
+// строка i всех массивов относится к entities[i]. Массивы компонентов не из маски пусты.
+struct Archetype {
+    Kind kind;
+    std::uint32_t mask;
+    Proc proc;
+    std::vector<EntityId> entities;
+    std::vector<std::uint32_t> names;
+    std::vector<int> health;
+    std::vector<int> attack;
+    std::vector<int> defense;
+    std::vector<Progress> progress;
+
+    size_t size() const { return entities.size(); }
+    bool has(std::uint32_t components) const { return (mask & components) == components; }
+};
+
+class World {
+private:
+    struct Location {
+        std::uint32_t archetype;
+        std::uint32_t row;
+        std::uint32_t generation;
+        bool alive;
+    };
+
+    std::vector<Archetype> archetypes;
+    std::vector<Location> locations;
+    std::vector<std::uint32_t> freeIds;
+    std::vector<std::string> names;
+    std::vector<std::uint32_t> freeNames;
+
+    std::uint32_t archetypeFor(Kind kind, std::uint32_t mask) {
+        for (std::uint32_t i = 0; i < archetypes.size(); ++i) {
+            if (archetypes[i].kind == kind && archetypes[i].mask == mask) return i;
+        }
+        archetypes.push_back({ kind, mask, procFor(kind), {}, {}, {}, {}, {}, {} });
+        return static_cast<std::uint32_t>(archetypes.size() - 1);
+    }
+
+    const Location& locate(EntityId id) const {
+        if (id.index >= locations.size() || !locations[id.index].alive || locations[id.index].generation != id.generation) {
+            throw std::logic_error("Stale entity id");
+        }
+        return locations[id.index];
+    }
+
+    template <typename T>
+    static void swapRemove(std::vector<T>& column, std::uint32_t row) {
+        if (column.empty()) return;
+        column[row] = std::move(column.back());
+        column.pop_back();
+    }
+
+public:
+    World() = default;
+    World(const World&) = delete;
+    World& operator=(const World&) = delete;
+
+    // Мир по умолчанию для сущностей, созданных без явного мира
+    static World& global() {
+        static World world;
+        return world;
+    }
+
+    EntityId create(Kind kind, std::uint32_t mask, const std::string& name, int h, int a, int d) {
+        std::uint32_t index;
+        if (!freeIds.empty()) {
+            index = freeIds.back();
+            freeIds.pop_back();
         }
         else {
-            std::cout << name << " attacks " << target.getName() << ", but it has no effect!\n";
+            index = static_cast<std::uint32_t>(locations.size());
+            locations.push_back({ 0, 0, 0, false });
         }
+
+        std::uint32_t archetype = archetypeFor(kind, mask);
+        Archetype& table = archetypes[archetype];
+        Location& location = locations[index];
+        location = { archetype, static_cast<std::uint32_t>(table.size()), location.generation + 1, true };
+        EntityId id{ index, location.generation };
+
+        table.entities.push_back(id);
+        if (mask & NameComponent) {
+            std::uint32_t handle;
+            if (!freeNames.empty()) {
+                handle = freeNames.back();
+                freeNames.pop_back();
+                names[handle] = name;
+            }
+            else {
+                handle = static_cast<std::uint32_t>(names.size());
+                names.push_back(name);
+            }
+            table.names.push_back(handle);
+        }
+        if (mask & HealthComponent) table.health.push_back(h);
+        if (mask & AttackComponent) table.attack.push_back(a);
+        if (mask & DefenseComponent) table.defense.push_back(d);
+        if (mask & ProgressComponent) table.progress.push_back({ 1, 0 });
+        return id;
     }
 
-    virtual void displayInfo() const {
-        std::cout << "Name: " << name << ", HP: " << health
-            << ", Attack: " << attackPower << ", Defense: " << defense << std::endl;
+    // Последняя строка архетипа переезжает на место удалённой, массивы остаются плотными
+    void destroy(EntityId id) {
+        const Location location = locate(id);
+        Archetype& table = archetypes[location.archetype];
+        if (table.has(NameComponent)) {
+            freeNames.push_back(table.names[location.row]);
+            names[table.names[location.row]].clear();
+        }
+
+        EntityId moved = table.entities.back();
+        swapRemove(table.entities, location.row);
+        swapRemove(table.names, location.row);
+        swapRemove(table.health, location.row);
+        swapRemove(table.attack, location.row);
+        swapRemove(table.defense, location.row);
+        swapRemove(table.progress, location.row);
+        if (moved.index != id.index) locations[moved.index].row = location.row;
+
+        locations[id.index].alive = false;
+        freeIds.push_back(id.index);
     }
 
-    virtual void heal(int amount) {
-        health += amount;
-        std::cout << name << " heals for " << amount << " HP.\n";
+    size_t size() const { return locations.size() - freeIds.size(); }
+
+    const Archetype& archetypeOf(EntityId id) const { return archetypes[locate(id).archetype]; }
+
+    const std::string& name(EntityId id) const {
+        const Location& l = locate(id);
+        return names[archetypes[l.archetype].names[l.row]];
     }
 
-    // Геттеры и сеттеры
-    std::string getName() const { return name; }
-    int getHealth() const { return health; }
-    void setHealth(int h) { health = h; }
-    void reduceHealth(int amount) { health -= amount; }
-    int getAttack() const { return attackPower; }
-    int getDefense() const { return defense; }
+    int& health(EntityId id) {
+        const Location& l = locate(id);
+        return archetypes[l.archetype].health[l.row];
+    }
 
-    virtual ~Entity() {}
+    int attack(EntityId id) const {
+        const Location& l = locate(id);
+        return archetypes[l.archetype].attack[l.row];
+    }
+
+    int defense(EntityId id) const {
+        const Location& l = locate(id);
+        return archetypes[l.archetype].defense[l.row];
+    }
+
+    Progress& progress(EntityId id) {
+        const Location& l = locate(id);
+        Archetype& table = archetypes[l.archetype];
+        if (!table.has(ProgressComponent)) throw std::logic_error("Entity has no progress component");
+        return table.progress[l.row];
+    }
+
+    // Вызывает f(Archetype&) для каждого архетипа, где есть все компоненты из components
+    template <typename F>
+    void each(std::uint32_t components, F&& f) {
+        for (Archetype& table : archetypes) {
+            if (table.has(components) && table.size() > 0) f(table);
+        }
+    }
 };
 
-class Character : public Entity {
+// Системы: проходят плотные массивы архетипов
+
+// Восстановление здоровья всем, не выше cap
+void regenerateSystem(World& world, int amount, int cap) {
+    world.each(HealthComponent, [&](Archetype& table) {
+        for (int& h : table.health) h = std::min(h + amount, cap);
+    });
+}
+
+// Опыт всем, у кого он есть; каждые 100 очков - новый уровень
+void experienceSystem(World& world, int amount) {
+    world.each(ProgressComponent, [&](Archetype& table) {
+        for (Progress& p : table.progress) {
+            p.experience += amount;
+            if (p.experience >= 100) {
+                ++p.level;
+                p.experience -= 100;
+            }
+        }
+    });
+}
+
+// ==== Классы ====
+// Объекты - тонкие представления: хранят только мир и номер сущности, данные лежат в World
+
+class Entity {
+protected:
+    World* world;
+    EntityId id;
+
+    Entity(Kind kind, std::uint32_t mask, const std::string& n, int h, int a, int d, World& w)
+        : world(&w), id(w.create(kind, mask, n, h, a, d)) {
+    }
+
 public:
-    Character(const std::string& n, int h, int a, int d)
-        : Entity(n, h, a, d) {
+    Entity(const std::string& n, int h, int a, int d, World& w = World::global())
+        : Entity(Kind::Entity, COMBATANT, n, h, a, d, w) {
     }
 
-    void attack(Entity& target) override {
-        int damage = attackPower - target.getDefense();
+    Entity(const Entity&) = delete;
+    Entity& operator=(const Entity&) = delete;
+
+    Proc proc() const { return world->archetypeOf(id).proc; }
+
+    // Один удар по цели; броски берутся из rng (below(n) -> [0, n)), сообщение печатается,
+    // если verbose. Возвращает нанесённый урон.
+    template <typename Rng>
+    int strike(Entity& target, Rng& rng, bool verbose) {
+        int damage = getAttack() - target.getDefense();
         if (damage > 0) {
-            if (rand() % 100 < 20) {
-                damage *= 2;
-                std::cout << "Critical hit! ";
+            Proc p = proc();
+            if (p.chance > 0 && static_cast<int>(rng.below(100)) < p.chance) {
+                damage = damage * p.multiplier + p.bonus;
+                if (verbose) std::cout << p.message;
             }
             target.reduceHealth(damage);
-            std::cout << name << " attacks " << target.getName() << " for " << damage << " damage!\n";
-        }
-        else {
-            std::cout << name << " attacks " << target.getName() << ", but it has no effect!\n";
+            if (verbose) std::cout << getName() << " attacks " << target.getName() << " for " << damage << " damage!\n";
+            return damage;
         }
+        if (verbose) std::cout << getName() << " attacks " << target.getName() << ", but it has no effect!\n";
+        return 0;
+    }
+
+    virtual void attack(Entity& target) {
+        strike(target, threadRng(), true);
+    }
+
+    virtual void displayInfo() const {
+        std::cout << "Name: " << getName() << ", HP: " << getHealth()
+            << ", Attack: " << getAttack() << ", Defense: " << getDefense() << std::endl;
+    }
+
+    virtual void heal(int amount) {
+        world->health(id) += amount;
+        std::cout << getName() << " heals for " << amount << " HP.\n";
+    }
+
+    // Геттеры и сеттеры
+    const std::string& getName() const { return world->name(id); }
+    int getHealth() const { return world->health(id); }
+    void setHealth(int h) { world->health(id) = h; }
+    void reduceHealth(int amount) { world->health(id) -= amount; }
+    int getAttack() const { return world->attack(id); }
+    int getDefense() const { return world->defense(id); }
+    bool isAlive() const { return getHealth() > 0; }
+    EntityId getId() const { return id; }
+
+    virtual ~Entity() { world->destroy(id); }
+};
+
+class Character : public Entity {
+public:
+    Character(const std::string& n, int h, int a, int d, World& w = World::global())
+        : Entity(Kind::Character, COMBATANT | ProgressComponent, n, h, a, d, w) {
     }
 
     void heal(int amount) override {
-        health += amount;
-        std::cout << name << " uses a healing potion and recovers " << amount << " HP!\n";
+        world->health(id) += amount;
+        std::cout << getName() << " uses a healing potion and recovers " << amount << " HP!\n";
     }
 
+    int getLevel() const { return world->progress(id).level; }
+    int getExperience() const { return world->progress(id).experience; }
+
     void displayInfo() const override {
-        std::cout << "Character: " << name << ", HP: " << health
-            << ", Attack: " << attackPower << ", Defense: " << defense << std::endl;
+        std::cout << "Character: " << getName() << ", HP: " << getHealth()
+            << ", Attack: " << getAttack() << ", Defense: " << getDefense() << std::endl;
     }
 };
 
 class Monster : public Entity {
-public:
-    Monster(const std::string& n, int h, int a, int d)
-        : Entity(n, h, a, d) {
+protected:
+    Monster(Kind kind, const std::string& n, int h, int a, int d, World& w)
+        : Entity(kind, COMBATANT, n, h, a, d, w) {
     }
 
-    void attack(Entity& target) override {
-        int damage = attackPower - target.getDefense();
-        if (damage > 0) {
-            if (rand() % 100 < 30) {
-                damage += 5;
-                std::cout << "Poisonous attack! ";
-            }
-            target.reduceHealth(damage);
-            std::cout << name << " attacks " << target.getName() << " for " << damage << " damage!\n";
-        }
-        else {
-            std::cout << name << " attacks " << target.getName() << ", but it has no effect!\n";
-        }
+public:
+    Monster(const std::string& n, int h, int a, int d, World& w = World::global())
+        : Monster(Kind::Monster, n, h, a, d, w) {
     }
 
     void displayInfo() const override {
-        std::cout << "Monster: " << name << ", HP: " << health
-            << ", Attack: " << attackPower << ", Defense: " << defense << std::endl;
+        std::cout << "Monster: " << getName() << ", HP: " << getHealth()
+            << ", Attack: " << getAttack() << ", Defense: " << getDefense() << std::endl;
     }
 };
 
 class Boss : public Monster {
 public:
-    Boss(const std::string& n, int h, int a, int d)
-        : Monster(n, h, a, d) {
+    Boss(const std::string& n, int h, int a, int d, World& w = World::global())
+        : Monster(Kind::Boss, n, h, a, d, w) {
     }
 
-    void attack(Entity& target) override {
-        int damage = attackPower - target.getDefense();
-        if (damage > 0) {
-            if (rand() % 100 < 40) {
-                damage += 10;
-                std::cout << "Flaming strike! ";
-            }
-            target.reduceHealth(damage);
-            std::cout << name << " attacks " << target.getName() << " for " << damage << " damage!\n";
+    void displayInfo() const override {
+        std::cout << "Boss: " << getName() << ", HP: " << getHealth()
+            << ", Attack: " << getAttack() << ", Defense: " << getDefense() << std::endl;
+    }
+};
+
+// ==== Прогон баланса методом Монте-Карло ====
+
+// Счётчиковый генератор: i-е число потока - хеш пары (ключ потока, i), так что
+// бой с номером n получает одни и те же броски на любом потоке и при любом числе потоков
+class CounterRng {
+private:
+    std::uint64_t key;
+    std::uint64_t counter = 0;
+
+    static std::uint64_t mix(std::uint64_t z) {
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+public:
+    CounterRng(std::uint64_t seed, std::uint64_t stream)
+        : key(mix(seed + mix(stream + 0x9E3779B97F4A7C15ull))) {
+    }
+
+    std::uint64_t next() {
+        return mix(key + 0x9E3779B97F4A7C15ull * ++counter);
+    }
+
+    unsigned below(unsigned n) {
+        return lemireBelow(n, [this] { return static_cast<std::uint32_t>(next()); });
+    }
+};
+
+// Характеристики участника для прогона
+struct CombatantConfig {
+    std::string kind;  // character, monster или boss
+    std::string name;
+    int health;
+    int attack;
+    int defense;
+};
+
+std::unique_ptr<Entity> makeCombatant(const CombatantConfig& config, World& world) {
+    if (config.kind == "character") return std::make_unique<Character>(config.name, config.health, config.attack, config.defense, world);
+    if (config.kind == "monster") return std::make_unique<Monster>(config.name, config.health, config.attack, config.defense, world);
+    if (config.kind == "boss") return std::make_unique<Boss>(config.name, config.health, config.attack, config.defense, world);
+    throw std::invalid_argument("Unknown combatant kind: " + config.kind);
+}
+
+// Итоги боёв одного сочетания; складываются из частичных итогов потоков
+struct BalanceStats {
+    static constexpr int MAX_ROUNDS = 1000;  // дольше - ничья
+
+    std::uint64_t battles = 0;
+    std::uint64_t wins = 0;
+    std::uint64_t draws = 0;
+    std::vector<std::uint64_t> killRounds = std::vector<std::uint64_t>(MAX_ROUNDS + 1);  // раунд победы героя
+    std::vector<std::uint64_t> deathRounds = std::vector<std::uint64_t>(MAX_ROUNDS + 1); // раунд гибели героя
+
+    void merge(const BalanceStats& other) {
+        battles += other.battles;
+        wins += other.wins;
+        draws += other.draws;
+        for (int r = 0; r <= MAX_ROUNDS; ++r) {
+            killRounds[r] += other.killRounds[r];
+            deathRounds[r] += other.deathRounds[r];
         }
-        else {
-            std::cout << name << " attacks " << target.getName() << ", but it has no effect!\n";
+    }
+};
+
+// Бой героя с противником по раундам: герой бьёт первым
+void simulateBattle(Entity& hero, Entity& enemy, CounterRng& rng, BalanceStats& stats) {
+    ++stats.battles;
+    for (int round = 1; round <= BalanceStats::MAX_ROUNDS; ++round) {
+        hero.strike(enemy, rng, false);
+        if (!enemy.isAlive()) {
+            ++stats.wins;
+            ++stats.killRounds[round];
+            return;
+        }
+        enemy.strike(hero, rng, false);
+        if (!hero.isAlive()) {
+            ++stats.deathRounds[round];
+            return;
         }
     }
+    ++stats.draws;
+}
 
-    void displayInfo() const override {
-        std::cout << "Boss: " << name << ", HP: " << health
-            << ", Attack: " << attackPower << ", Defense: " << defense << std::endl;
+// Диапазоны номеров боёв по потокам с кражей работы: владелец берёт порции с начала
+// своего диапазона, освободившийся поток забирает вторую половину чужого.
+// Начало и конец диапазона упакованы в одно 64-битное слово, обе стороны меняют его CAS.
+class WorkStealingRanges {
+private:
+    struct alignas(64) Slot {
+        std::atomic<std::uint64_t> range{ 0 };
+    };
+
+    std::vector<Slot> slots;
+
+    static std::uint64_t pack(std::uint32_t begin, std::uint32_t end) {
+        return (static_cast<std::uint64_t>(begin) << 32) | end;
+    }
+
+public:
+    WorkStealingRanges(std::uint32_t total, unsigned workers) : slots(workers) {
+        for (unsigned w = 0; w < workers; ++w) {
+            auto begin = static_cast<std::uint32_t>(static_cast<std::uint64_t>(total) * w / workers);
+            auto end = static_cast<std::uint32_t>(static_cast<std::uint64_t>(total) * (w + 1) / workers);
+            slots[w].range.store(pack(begin, end), std::memory_order_relaxed);
+        }
+    }
+
+    // Следующая порция для потока worker; false, если работы нигде не осталось
+    bool next(unsigned worker, std::uint32_t chunk, std::uint32_t& begin, std::uint32_t& end) {
+        for (;;) {
+            auto& own = slots[worker].range;
+            std::uint64_t current = own.load(std::memory_order_acquire);
+            auto b = static_cast<std::uint32_t>(current >> 32);
+            auto e = static_cast<std::uint32_t>(current);
+            if (b < e) {
+                std::uint32_t take = std::min(chunk, e - b);
+                if (own.compare_exchange_weak(current, pack(b + take, e), std::memory_order_acq_rel)) {
+                    begin = b;
+                    end = b + take;
+                    return true;
+                }
+                continue;
+            }
+            if (!steal(worker)) return false;
+        }
+    }
+
+private:
+    bool steal(unsigned thief) {
+        for (unsigned k = 1; k < slots.size(); ++k) {
+            auto& victim = slots[(thief + k) % slots.size()].range;
+            std::uint64_t current = victim.load(std::memory_order_acquire);
+            for (;;) {
+                auto b = static_cast<std::uint32_t>(current >> 32);
+                auto e = static_cast<std::uint32_t>(current);
+                if (b >= e) break;
+                std::uint32_t middle = b + (e - b) / 2;
+                if (victim.compare_exchange_weak(current, pack(b, middle), std::memory_order_acq_rel)) {
+                    // Украденная половина становится своим диапазоном; свой слот сейчас пуст
+                    slots[thief].range.store(pack(middle, e), std::memory_order_release);
+                    return true;
+                }
+            }
+        }
+        return false;
     }
 };
 
-int main() {
-    srand(static_cast<unsigned>(time(0)));
+// battles боёв героя с противником на threads потоках; бой n использует поток случайных чисел (seed, n)
+BalanceStats runBalance(const CombatantConfig& heroConfig, const CombatantConfig& enemyConfig,
+    std::uint32_t battles, std::uint64_t seed, unsigned threads) {
+    const std::uint32_t chunk = 1024;
+    WorkStealingRanges ranges(battles, threads);
+    std::vector<BalanceStats> partial(threads);
+
+    auto worker = [&](unsigned w) {
+        World world;
+        auto hero = makeCombatant(heroConfig, world);
+        auto enemy = makeCombatant(enemyConfig, world);
+        std::uint32_t begin, end;
+        while (ranges.next(w, chunk, begin, end)) {
+            for (std::uint32_t n = begin; n < end; ++n) {
+                hero->setHealth(heroConfig.health);
+                enemy->setHealth(enemyConfig.health);
+                CounterRng rng(seed, n);
+                simulateBattle(*hero, *enemy, rng, partial[w]);
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned w = 1; w < threads; ++w) pool.emplace_back(worker, w);
+    worker(0);
+    for (auto& t : pool) t.join();
+
+    BalanceStats total;
+    for (const auto& p : partial) total.merge(p);
+    return total;
+}
+
+// Доля и её 95% доверительный интервал Уилсона
+void printRate(const char* label, std::uint64_t hits, std::uint64_t total) {
+    if (total == 0) {
+        std::cout << "  " << label << ": none\n";
+        return;
+    }
+
+    const double z = 1.96;
+    double p = static_cast<double>(hits) / total;
+    double n = static_cast<double>(total);
+    double center = (p + z * z / (2 * n)) / (1 + z * z / n);
+    double half = z * std::sqrt(p * (1 - p) / n + z * z / (4 * n * n)) / (1 + z * z / n);
+    std::cout << "  " << label << ": " << std::fixed << std::setprecision(2) << 100 * p << "% [95% CI "
+        << 100 * (center - half) << "%, " << 100 * (center + half) << "%]\n";
+}
+
+// Среднее, его 95% доверительный интервал и перцентили по гистограмме раундов
+void printRounds(const char* label, const std::vector<std::uint64_t>& histogram) {
+    std::uint64_t count = 0;
+    double sum = 0, squares = 0;
+    for (size_t r = 0; r < histogram.size(); ++r) {
+        count += histogram[r];
+        sum += static_cast<double>(r) * histogram[r];
+        squares += static_cast<double>(r) * r * histogram[r];
+    }
+    if (count == 0) {
+        std::cout << "  " << label << ": none\n";
+        return;
+    }
+
+    double mean = sum / count;
+    double variance = count > 1 ? (squares - sum * mean) / (count - 1) : 0;
+    double half = 1.96 * std::sqrt(std::max(variance, 0.0) / count);
+    auto percentile = [&](double q) {
+        auto target = static_cast<std::uint64_t>(std::ceil(q * count));
+        std::uint64_t seen = 0;
+        for (size_t r = 0; r < histogram.size(); ++r) {
+            seen += histogram[r];
+            if (seen >= target) return r;
+        }
+        return histogram.size() - 1;
+    };
+    std::cout << "  " << label << ": mean " << std::fixed << std::setprecision(3) << mean
+        << " rounds [95% CI " << mean - half << ", " << mean + half << "], p50 " << percentile(0.5)
+        << ", p90 " << percentile(0.9) << ", p99 " << percentile(0.99) << ", max " << percentile(1.0) << "\n";
+}
+
+// Участники из файла: по строке "character|monster|boss имя HP атака защита",
+// первая строка - герой, остальные - его противники
+std::vector<CombatantConfig> loadCombatants(const std::string& filename) {
+    std::ifstream in(filename);
+    if (!in) throw std::runtime_error("Cannot open config file: " + filename);
+    std::vector<CombatantConfig> configs;
+    CombatantConfig config;
+    while (in >> config.kind >> config.name >> config.health >> config.attack >> config.defense) {
+        World scratch;
+        makeCombatant(config, scratch);
+        configs.push_back(config);
+    }
+    if (configs.size() < 2) throw std::runtime_error("Config needs a hero and at least one enemy");
+    return configs;
+}
+
+// Число боёв из командной строки: без знака и меньше 2^32, иначе исключение
+std::uint32_t parseBattleCount(const std::string& text) {
+    std::uint32_t value = 0;
+    auto [end, err] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (err == std::errc::result_out_of_range) {
+        throw std::out_of_range("Battle count is too large: " + text);
+    }
+    if (err != std::errc() || end != text.data() + text.size()) {
+        throw std::invalid_argument("Invalid battle count: " + text);
+    }
+    return value;
+}
+
+// --balance <боёв> [seed] [файл]: герой против каждого противника
+int runBalanceTool(int argc, char* argv[]) {
+    std::uint32_t battles = argc > 2 ? parseBattleCount(argv[2]) : 1000000;
+    std::uint64_t seed = argc > 3 ? std::stoull(argv[3]) : 1;
+    std::vector<CombatantConfig> configs = argc > 4 ? loadCombatants(argv[4]) : std::vector<CombatantConfig>{
+        { "character", "Hero", 100, 20, 10 },
+        { "monster", "Goblin", 50, 15, 5 },
+        { "boss", "Dragon", 150, 30, 20 },
+    };
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+
+    std::cout << "battles per matchup: " << battles << ", seed: " << seed << ", threads: " << threads << "\n";
+    for (size_t i = 1; i < configs.size(); ++i) {
+        auto start = std::chrono::steady_clock::now();
+        BalanceStats stats = runBalance(configs[0], configs[i], battles, seed + i, threads);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << "\n" << configs[0].name << " vs " << configs[i].name << " ("
+            << std::fixed << std::setprecision(1) << stats.battles / seconds / 1e6 << " M battles/s)\n";
+        printRate("hero win rate", stats.wins, stats.battles);
+        printRate("draws", stats.draws, stats.battles);
+        printRounds("time to kill", stats.killRounds);
+        printRounds("time to death", stats.deathRounds);
+    }
+    return 0;
+}
+
+// Стоимость броска 0..99: rand() % 100, xoshiro поштучно и пачкой, и rand() против
+// генераторов потоков при нескольких потоках
+void benchmarkRng(size_t count) {
+    auto time = [&](auto&& body) {
+        auto start = std::chrono::steady_clock::now();
+        std::uint64_t sum = body();
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / count;
+        [[maybe_unused]] static volatile std::uint64_t sink;
+        sink = sum;
+        return ns;
+    };
+
+    double libc = time([&] {
+        LibcRng rng;
+        std::uint64_t sum = 0;
+        for (size_t i = 0; i < count; ++i) sum += rng.below(100);
+        return sum;
+    });
+    double single = time([&] {
+        Xoshiro256& rng = threadRng();
+        std::uint64_t sum = 0;
+        for (size_t i = 0; i < count; ++i) sum += rng.below(100);
+        return sum;
+    });
+    double batched = time([&] {
+        std::vector<unsigned> rolls(4096);
+        std::uint64_t sum = 0;
+        for (size_t done = 0; done < count; done += rolls.size()) {
+            threadRng().fill(rolls.data(), rolls.size(), 100);
+            for (unsigned r : rolls) sum += r;
+        }
+        return sum;
+    });
+
+    const unsigned threads = 4;
+    auto parallel = [&](auto&& roll) {
+        return time([&] {
+            std::atomic<std::uint64_t> sum{ 0 };
+            std::vector<std::thread> pool;
+            for (unsigned t = 0; t < threads; ++t) {
+                pool.emplace_back([&] {
+                    std::uint64_t local = 0;
+                    for (size_t i = 0; i < count / threads; ++i) local += roll();
+                    sum += local;
+                });
+            }
+            for (auto& t : pool) t.join();
+            return sum.load();
+        });
+    };
+    double libcThreads = parallel([] { return static_cast<unsigned>(rand()) % 100; });
+    double xoshiroThreads = parallel([] { return threadRng().below(100); });
+
+    // Смещение rand() % 100: доля бросков меньше 20 (шанс крита) против точных 20%
+    Xoshiro256 check(42);
+    std::uint64_t hits = 0;
+    const size_t samples = 10000000;
+    for (size_t i = 0; i < samples; ++i) hits += check.below(100) < 20;
+
+    std::cout << "numbers: " << count << "\n"
+        << "rand() % 100: " << libc << " ns\n"
+        << "xoshiro below(100): " << single << " ns\n"
+        << "xoshiro fill: " << batched << " ns\n"
+        << "rand(), " << threads << " threads: " << libcThreads << " ns\n"
+        << "threadRng(), " << threads << " threads: " << xoshiroThreads << " ns\n"
+        << "below(100) < 20: " << 100.0 * hits / samples << "%" << std::endl;
+}
+
+// Такт для count сущностей: системы по плотным массивам против того же обновления
+// через объекты-представления
+void benchmarkEcs(size_t count) {
+    World world;
+    std::vector<std::unique_ptr<Entity>> views;
+    views.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        int h = 50 + static_cast<int>(i % 50);
+        switch (i % 3) {
+        case 0: views.push_back(std::make_unique<Character>("Hero", h, 20, 10, world)); break;
+        case 1: views.push_back(std::make_unique<Monster>("Goblin", h, 15, 5, world)); break;
+        default: views.push_back(std::make_unique<Boss>("Dragon", h, 30, 20, world)); break;
+        }
+    }
+
+    const int ticks = 20;
+    auto time = [&](auto&& tick) {
+        auto start = std::chrono::steady_clock::now();
+        for (int t = 0; t < ticks; ++t) tick();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / ticks;
+    };
+    double systems = time([&] {
+        regenerateSystem(world, 1, 100);
+        experienceSystem(world, 10);
+    });
+    double objects = time([&] {
+        for (auto& e : views) e->setHealth(std::min(e->getHealth() + 1, 100));
+    });
+
+    long long total = 0;
+    world.each(HealthComponent, [&](Archetype& table) {
+        for (int h : table.health) total += h;
+    });
+    int archetypes = 0;
+    world.each(0, [&](Archetype&) { ++archetypes; });
+
+    std::cout << "entities: " << world.size() << " in " << archetypes << " archetypes\n"
+        << "systems (regeneration + experience): " << systems << " ms per tick\n"
+        << "regeneration through objects: " << objects << " ms per tick\n"
+        << "health total: " << total << ", hero level: "
+        << static_cast<Character&>(*views[0]).getLevel() << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 2 && std::string(argv[1]) == "--bench" && std::string(argv[2]) == "ecs") {
+        benchmarkEcs(argc > 3 ? std::stoull(argv[3]) : 1000000);
+        return 0;
+    }
+    if (argc > 2 && std::string(argv[1]) == "--bench" && std::string(argv[2]) == "rng") {
+        benchmarkRng(argc > 3 ? std::stoull(argv[3]) : 100000000);
+        return 0;
+    }
+
+    if (argc > 1 && std::string(argv[1]) == "--balance") {
+        try {
+            return runBalanceTool(argc, argv);
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            return 1;
+        }
+    }
+
+    seedThreadRngs(static_cast<std::uint64_t>(time(0)));
 
     Character hero("Hero", 100, 20, 10);
     Monster goblin("Goblin", 50, 15, 5);
@@ -6,7 +6,52 @@
 #include <stdexcept>
 #include <string>
 #include <sstream>
+#include <iterator>
 #include <functional>
+#include <unordered_map>
+#include <string_view>
+#include <cstdint>
+#include <limits>
+#include <chrono>
+#include <span>
+#include <bit>
+#include <cstring>
+#include <charconv>
+#include <thread>
+#include <future>
+#include <atomic>
+#include <mutex>
+#include <optional>
+#include <filesystem>
+#include <cstddef>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <io.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ACS_HAS_SSE2 1
+#include <emmintrin.h>
+#endif
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define ACS_X86 1
+#define ACS_TARGET(isa) __attribute__((target(isa)))
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <immintrin.h>
+#include <intrin.h>
+#define ACS_X86 1
+#define ACS_TARGET(isa)
+#endif
 
 using namespace std;
 
@@ -32,6 +77,38 @@ AccessLevel fromInt(int val) {
     return static_cast<AccessLevel>(val);
 }
 
+enum class UserType : uint8_t {
+    Student = 1,
+    Teacher = 2,
+    Administrator = 3
+};
+
+UserType toUserType(string_view type) {
+    if (type == "Student") return UserType::Student;
+    if (type == "Teacher") return UserType::Teacher;
+    if (type == "Administrator") return UserType::Administrator;
+    throw invalid_argument("Unknown user type");
+}
+
+string toString(UserType type) {
+    switch (type) {
+    case UserType::Student: return "Student";
+    case UserType::Teacher: return "Teacher";
+    case UserType::Administrator: return "Administrator";
+    default: return "Unknown";
+    }
+}
+
+// Label of the type-specific field, as printed by displayInfo
+const char* extraFieldName(UserType type) {
+    switch (type) {
+    case UserType::Student: return "Group";
+    case UserType::Teacher: return "Department";
+    case UserType::Administrator: return "Position";
+    default: return "Extra";
+    }
+}
+
 // -------------------- Exceptions --------------------
 
 class InvalidAccessLevelException : public exception {
@@ -70,15 +147,15 @@ protected:
     AccessLevel accessLevel;
 
 public:
-    User(const string& name, int id, AccessLevel level)
-        : name(name), id(id), accessLevel(level) {
-        Validation::checkName(name);
+    User(string name, int id, AccessLevel level)
+        : name(move(name)), id(id), accessLevel(level) {
+        Validation::checkName(this->name);
         Validation::checkAccessLevel(level);
     }
 
     virtual ~User() = default;
 
-    string getName() const { return name; }
+    const string& getName() const { return name; }
     int getId() const { return id; }
     AccessLevel getAccessLevel() const { return accessLevel; }
 
@@ -99,9 +176,10 @@ public:
     }
 
     virtual string getType() const = 0;
+    virtual const string& getExtra() const = 0;
     virtual string serialize() const = 0;
 
-    static unique_ptr<User> deserialize(const string& line);
+    static unique_ptr<User> deserialize(string_view line);
 };
 
 // -------------------- Derived Users --------------------
@@ -109,8 +187,8 @@ public:
 class Student : public User {
     string group;
 public:
-    Student(const string& name, int id, const string& group)
-        : User(name, id, AccessLevel::Student), group(group) {}
+    Student(string name, int id, string group)
+        : User(move(name), id, AccessLevel::Student), group(move(group)) {}
 
     void displayInfo() const override {
         User::displayInfo();
@@ -118,6 +196,7 @@ public:
     }
 
     string getType() const override { return "Student"; }
+    const string& getExtra() const override { return group; }
 
     string serialize() const override {
         return "Student," + name + "," + to_string(id) + "," + to_string(static_cast<int>(accessLevel)) + "," + group;
@@ -127,8 +206,8 @@ public:
 class Teacher : public User {
     string department;
 public:
-    Teacher(const string& name, int id, const string& department)
-        : User(name, id, AccessLevel::Teacher), department(department) {}
+    Teacher(string name, int id, string department)
+        : User(move(name), id, AccessLevel::Teacher), department(move(department)) {}
 
     void displayInfo() const override {
         User::displayInfo();
@@ -136,6 +215,7 @@ public:
     }
 
     string getType() const override { return "Teacher"; }
+    const string& getExtra() const override { return department; }
 
     string serialize() const override {
         return "Teacher," + name + "," + to_string(id) + "," + to_string(static_cast<int>(accessLevel)) + "," + department;
@@ -145,8 +225,8 @@ public:
 class Administrator : public User {
     string position;
 public:
-    Administrator(const string& name, int id, const string& position)
-        : User(name, id, AccessLevel::Administrator), position(position) {}
+    Administrator(string name, int id, string position)
+        : User(move(name), id, AccessLevel::Administrator), position(move(position)) {}
 
     void displayInfo() const override {
         User::displayInfo();
@@ -154,6 +234,7 @@ public:
     }
 
     string getType() const override { return "Administrator"; }
+    const string& getExtra() const override { return position; }
 
     string serialize() const override {
         return "Administrator," + name + "," + to_string(id) + "," + to_string(static_cast<int>(accessLevel)) + "," + position;
@@ -171,7 +252,7 @@ public:
         Validation::checkAccessLevel(level);
     }
 
-    string getName() const { return name; }
+    const string& getName() const { return name; }
     AccessLevel getRequiredAccessLevel() const { return requiredAccess; }
 
     bool checkAccess(const User& user) const {
@@ -195,143 +276,2649 @@ public:
     }
 };
 
-// -------------------- User Deserialization --------------------
+// -------------------- CSV Parsing --------------------
 
-unique_ptr<User> User::deserialize(const string& line) {
-    stringstream ss(line);
-    vector<string> tokens;
-    string token;
-    while (getline(ss, token, ',')) tokens.push_back(token);
+enum class ParseError {
+    None,
+    MissingField,
+    InvalidNumber,
+    InvalidAccessLevel,
+    UnknownType,
+    EmptyName
+};
 
-    if (tokens.size() < 5) throw invalid_argument("Invalid user format");
+const char* toString(ParseError error) {
+    switch (error) {
+    case ParseError::None: return "No error";
+    case ParseError::MissingField: return "Invalid user format";
+    case ParseError::InvalidNumber: return "Invalid number";
+    case ParseError::InvalidAccessLevel: return "Invalid access level int";
+    case ParseError::UnknownType: return "Unknown user type";
+    case ParseError::EmptyName: return "Name cannot be empty!";
+    default: return "Unknown error";
+    }
+}
 
-    string type = tokens[0];
-    string name = tokens[1];
-    int id = stoi(tokens[2]);
-    AccessLevel level = fromInt(stoi(tokens[3]));
-    string extra = tokens[4];
+// Fields of one "Type,Name,Id,Level,Extra" line; views point into the line
+struct UserFields {
+    UserType type;
+    string_view name;
+    int id;
+    AccessLevel level;
+    string_view extra;
+};
+
+// Splits off the text up to the next comma; false when nothing is left
+inline bool nextField(string_view& rest, string_view& field) {
+    if (rest.data() == nullptr) return false;
+    size_t pos = rest.find(',');
+    if (pos == string_view::npos) {
+        field = rest;
+        rest = string_view();
+    }
+    else {
+        field = rest.substr(0, pos);
+        rest.remove_prefix(pos + 1);
+    }
+    return true;
+}
 
-    if (type == "Student") return make_unique<Student>(name, id, extra);
-    if (type == "Teacher") return make_unique<Teacher>(name, id, extra);
-    if (type == "Administrator") return make_unique<Administrator>(name, id, extra);
+inline bool parseInt(string_view text, int& value) {
+    auto [end, ec] = from_chars(text.data(), text.data() + text.size(), value);
+    return ec == errc() && end != text.data();
+}
 
-    throw invalid_argument("Unknown user type");
+// Parses without allocating or throwing; extra fields after the fifth are ignored
+ParseError parseUserFields(string_view line, UserFields& out) noexcept {
+    string_view rest = line.empty() ? string_view() : line;
+    string_view type, idText, levelText;
+    if (!nextField(rest, type) || !nextField(rest, out.name) || !nextField(rest, idText)
+        || !nextField(rest, levelText) || !nextField(rest, out.extra))
+        return ParseError::MissingField;
+
+    if (type == "Student") out.type = UserType::Student;
+    else if (type == "Teacher") out.type = UserType::Teacher;
+    else if (type == "Administrator") out.type = UserType::Administrator;
+    else return ParseError::UnknownType;
+
+    int level = 0;
+    if (!parseInt(idText, out.id) || !parseInt(levelText, level)) return ParseError::InvalidNumber;
+    if (level < 1 || level > 3) return ParseError::InvalidAccessLevel;
+    out.level = static_cast<AccessLevel>(level);
+
+    if (out.name.empty()) return ParseError::EmptyName;
+    return ParseError::None;
 }
 
-// -------------------- Access Control System --------------------
+// -------------------- User Deserialization --------------------
 
-template<typename T>
-class AccessControlSystem {
-    vector<unique_ptr<User>> users;
-    vector<T> resources;
+unique_ptr<User> makeUser(UserType type, string name, int id, AccessLevel level, string extra) {
+    unique_ptr<User> user;
+    switch (type) {
+    case UserType::Student: user = make_unique<Student>(move(name), id, move(extra)); break;
+    case UserType::Teacher: user = make_unique<Teacher>(move(name), id, move(extra)); break;
+    case UserType::Administrator: user = make_unique<Administrator>(move(name), id, move(extra)); break;
+    default: throw invalid_argument("Unknown user type");
+    }
+    if (user->getAccessLevel() != level) user->setAccessLevel(level);
+    return user;
+}
+
+// Throwing wrapper over parseUserFields for callers that report errors as exceptions
+UserFields parseUserLine(string_view line) {
+    UserFields f;
+    ParseError error = parseUserFields(line, f);
+    if (error == ParseError::EmptyName) throw EmptyNameException();
+    if (error != ParseError::None) throw invalid_argument(toString(error));
+    return f;
+}
+
+unique_ptr<User> User::deserialize(string_view line) {
+    UserFields f = parseUserLine(line);
+    return makeUser(f.type, string(f.name), f.id, f.level, string(f.extra));
+}
+
+// -------------------- Indexes --------------------
+
+// Open-addressing hash table (linear probing) from user id to position in users.
+// Probing works on raw arrays so snapshots can use a table mapped from disk.
+class IdIndex {
+    vector<int> keys;
+    vector<uint32_t> slots;
+    size_t count = 0;
+
+    static size_t bucket(int key, size_t capacity) {
+        // Fibonacci hashing: the top bits of the product select the bucket
+        unsigned shift = 64 - countr_zero(capacity);
+        return static_cast<size_t>((static_cast<uint64_t>(static_cast<uint32_t>(key)) * 0x9E3779B97F4A7C15ull) >> shift);
+    }
+
+    void rehash(size_t capacity) {
+        vector<int> oldKeys = move(keys);
+        vector<uint32_t> oldSlots = move(slots);
+        keys.assign(capacity, 0);
+        slots.assign(capacity, npos);
+        count = 0;
+        for (size_t i = 0; i < oldSlots.size(); ++i)
+            if (oldSlots[i] != npos) insert(oldKeys[i], oldSlots[i]);
+    }
 
 public:
-    void addUser(unique_ptr<User> user) {
-        users.push_back(move(user));
+    static constexpr uint32_t npos = numeric_limits<uint32_t>::max();
+
+    static uint32_t find(const int* keys, const uint32_t* slots, size_t capacity, int key) {
+        if (capacity == 0) return npos;
+        size_t mask = capacity - 1;
+        for (size_t i = bucket(key, capacity);; i = (i + 1) & mask) {
+            if (slots[i] == npos) return npos;
+            if (keys[i] == key) return slots[i];
+        }
     }
 
-    void addResource(const T& resource) {
-        resources.push_back(resource);
+    void clear() {
+        keys.clear();
+        slots.clear();
+        count = 0;
     }
 
-    bool checkAccess(int userId, const string& resName) const {
-        auto user = find_if(users.begin(), users.end(),
-            [userId](const unique_ptr<User>& u) { return u->getId() == userId; });
-        auto res = find_if(resources.begin(), resources.end(),
-            [resName](const T& r) { return r.getName() == resName; });
-        return user != users.end() && res != resources.end() && res->checkAccess(**user);
+    void reserve(size_t n) {
+        size_t capacity = 16;
+        while (capacity < n * 2) capacity <<= 1;
+        if (capacity > slots.size()) rehash(capacity);
     }
 
-    void displayAllUsers() const {
-        for (const auto& u : users) u->displayInfo();
+    // Keeps the first slot registered for an id, like find_if over users did
+    bool insert(int key, uint32_t slot) {
+        if ((count + 1) * 2 > slots.size()) reserve(count + 1);
+        size_t mask = slots.size() - 1;
+        for (size_t i = bucket(key, slots.size());; i = (i + 1) & mask) {
+            if (slots[i] == npos) {
+                keys[i] = key;
+                slots[i] = slot;
+                ++count;
+                return true;
+            }
+            if (keys[i] == key) return false;
+        }
     }
 
-    void displayAllResources() const {
-        for (const auto& r : resources) r.displayInfo();
+    uint32_t find(int key) const {
+        return find(keys.data(), slots.data(), slots.size(), key);
     }
 
-    User* findUserByName(const string& name) const {
-        auto it = find_if(users.begin(), users.end(),
-            [&name](const unique_ptr<User>& u) { return u->getName() == name; });
-        return it != users.end() ? it->get() : nullptr;
+    // Removes the entry for `slot` stored under `key`; later entries of the probe run
+    // are shifted back, as in NameTable::erase
+    bool erase(int key, uint32_t slot) {
+        if (slots.empty()) return false;
+        size_t mask = slots.size() - 1;
+        size_t i = bucket(key, slots.size());
+        while (slots[i] != slot || keys[i] != key) {
+            if (slots[i] == npos) return false;
+            i = (i + 1) & mask;
+        }
+        for (size_t j = (i + 1) & mask; slots[j] != npos; j = (j + 1) & mask) {
+            size_t home = bucket(keys[j], slots.size());
+            bool homeBetween = i <= j ? (home > i && home <= j) : (home > i || home <= j);
+            if (!homeBetween) {
+                keys[i] = keys[j];
+                slots[i] = slots[j];
+                i = j;
+            }
+        }
+        slots[i] = npos;
+        --count;
+        return true;
     }
 
-    void sortUsersBy(function<bool(const unique_ptr<User>&, const unique_ptr<User>&)> comp) {
-        sort(users.begin(), users.end(), comp);
+    // Adopts a table built elsewhere (e.g. a snapshot) without rehashing
+    void assign(span<const int> newKeys, span<const uint32_t> newSlots) {
+        keys.assign(newKeys.begin(), newKeys.end());
+        slots.assign(newSlots.begin(), newSlots.end());
+        count = slots.size() - static_cast<size_t>(std::count(slots.begin(), slots.end(), npos));
     }
 
-    void saveToFile(const string& filename) const {
-        ofstream out(filename);
-        if (!out) throw runtime_error("Can't open file!");
+    size_t size() const { return count; }
+
+    // Renumbers stored slots after the indexed array was reordered
+    void remapSlots(span<const uint32_t> newSlotOf) {
+        for (uint32_t& s : slots)
+            if (s != npos) s = newSlotOf[s];
+    }
 
-        for (const auto& u : users) out << u->serialize() << "\n";
+    span<const int> rawKeys() const { return keys; }
+    span<const uint32_t> rawSlots() const { return slots; }
+};
 
-        out << "RESOURCES\n";
-        for (const auto& r : resources) out << r.serialize() << "\n";
+// Open-addressing hash table from name to slot. Names stay in the owner's storage
+// and are fetched through nameOf(slot); the stored 32-bit hashes make rehashing
+// and most mismatches cheap. FNV-1a keeps hashes stable across builds for snapshots.
+class NameTable {
+    vector<uint32_t> slots;
+    vector<uint32_t> hashes;
+    size_t count = 0;
+
+    static size_t bucket(uint32_t hash, size_t capacity) {
+        unsigned shift = 64 - countr_zero(capacity);
+        return static_cast<size_t>((hash * 0x9E3779B97F4A7C15ull) >> shift);
     }
 
-    void loadFromFile(const string& filename) {
-        ifstream in(filename);
-        if (!in) throw runtime_error("Can't open file!");
+    void rehash(size_t capacity) {
+        vector<uint32_t> oldSlots = move(slots);
+        vector<uint32_t> oldHashes = move(hashes);
+        slots.assign(capacity, npos);
+        hashes.assign(capacity, 0);
+        size_t mask = capacity - 1;
+        for (size_t i = 0; i < oldSlots.size(); ++i) {
+            if (oldSlots[i] == npos) continue;
+            size_t j = bucket(oldHashes[i], capacity);
+            while (slots[j] != npos) j = (j + 1) & mask;
+            slots[j] = oldSlots[i];
+            hashes[j] = oldHashes[i];
+        }
+    }
 
-        users.clear();
-        resources.clear();
+public:
+    static constexpr uint32_t npos = IdIndex::npos;
 
-        string line;
-        bool readingResources = false;
-        while (getline(in, line)) {
-            if (line.empty()) continue;
-            if (line == "RESOURCES") {
-                readingResources = true;
-                continue;
+    static uint32_t hashName(string_view name) {
+        uint32_t h = 2166136261u;
+        for (char c : name) {
+            h ^= static_cast<uint8_t>(c);
+            h *= 16777619u;
+        }
+        return h;
+    }
+
+    template<typename NameOf>
+    static uint32_t find(const uint32_t* slots, const uint32_t* hashes, size_t capacity,
+        string_view name, NameOf&& nameOf) {
+        if (capacity == 0) return npos;
+        uint32_t h = hashName(name);
+        size_t mask = capacity - 1;
+        for (size_t i = bucket(h, capacity);; i = (i + 1) & mask) {
+            if (slots[i] == npos) return npos;
+            if (hashes[i] == h && nameOf(slots[i]) == name) return slots[i];
+        }
+    }
+
+    void clear() {
+        slots.clear();
+        hashes.clear();
+        count = 0;
+    }
+
+    void reserve(size_t n) {
+        size_t capacity = 16;
+        while (capacity < n * 2) capacity <<= 1;
+        if (capacity > slots.size()) rehash(capacity);
+    }
+
+    // Keeps the first slot registered for a name
+    template<typename NameOf>
+    bool insert(string_view name, uint32_t slot, NameOf&& nameOf) {
+        if ((count + 1) * 2 > slots.size()) reserve(count + 1);
+        uint32_t h = hashName(name);
+        size_t mask = slots.size() - 1;
+        for (size_t i = bucket(h, slots.size());; i = (i + 1) & mask) {
+            if (slots[i] == npos) {
+                slots[i] = slot;
+                hashes[i] = h;
+                ++count;
+                return true;
             }
+            if (hashes[i] == h && nameOf(slots[i]) == name) return false;
+        }
+    }
 
-            if (!readingResources)
-                users.push_back(User::deserialize(line));
-            else
-                resources.push_back(T::deserialize(line));
+    template<typename NameOf>
+    uint32_t find(string_view name, NameOf&& nameOf) const {
+        return find(slots.data(), hashes.data(), slots.size(), name, nameOf);
+    }
+
+    // Removes the entry for `slot` stored under `name`; later entries of the probe
+    // run are shifted back so lookups never need tombstones
+    bool erase(string_view name, uint32_t slot) {
+        if (slots.empty()) return false;
+        uint32_t h = hashName(name);
+        size_t mask = slots.size() - 1;
+        size_t i = bucket(h, slots.size());
+        while (slots[i] != slot || hashes[i] != h) {
+            if (slots[i] == npos) return false;
+            i = (i + 1) & mask;
+        }
+        for (size_t j = (i + 1) & mask; slots[j] != npos; j = (j + 1) & mask) {
+            size_t home = bucket(hashes[j], slots.size());
+            // Move j into the hole at i unless its home lies cyclically in (i, j]
+            bool homeBetween = i <= j ? (home > i && home <= j) : (home > i || home <= j);
+            if (!homeBetween) {
+                slots[i] = slots[j];
+                hashes[i] = hashes[j];
+                i = j;
+            }
         }
+        slots[i] = npos;
+        --count;
+        return true;
     }
+
+    void assign(span<const uint32_t> newSlots, span<const uint32_t> newHashes) {
+        slots.assign(newSlots.begin(), newSlots.end());
+        hashes.assign(newHashes.begin(), newHashes.end());
+        count = slots.size() - static_cast<size_t>(std::count(slots.begin(), slots.end(), npos));
+    }
+
+    size_t size() const { return count; }
+
+    void remapSlots(span<const uint32_t> newSlotOf) {
+        for (uint32_t& s : slots)
+            if (s != npos) s = newSlotOf[s];
+    }
+
+    span<const uint32_t> rawSlots() const { return slots; }
+    span<const uint32_t> rawHashes() const { return hashes; }
 };
 
-// -------------------- Main --------------------
+// -------------------- Batch Kernels --------------------
+
+// The AVX2 kernel is chosen at run time, so a build without -mavx2 still uses it
+inline bool hasAvx2() {
+    static const bool supported = [] {
+#if defined(ACS_X86) && defined(__GNUC__)
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") != 0;
+#elif defined(ACS_X86)
+        int info[4];
+        __cpuid(info, 1);
+        bool avx = (info[2] & (1 << 28)) != 0 && (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 6) == 6;
+        __cpuidex(info, 7, 0);
+        return avx && (info[1] & (1 << 5)) != 0;
+#else
+        return false;
+#endif
+    }();
+    return supported;
+}
 
-int main() {
-    try {
-        AccessControlSystem<Resource> system;
+#if defined(ACS_X86)
+// 32 levels per step; returns how many were compared
+ACS_TARGET("avx2")
+inline size_t compareLevelsAvx2(const uint8_t* have, const uint8_t* need, uint8_t* out, size_t n) {
+    const __m256i one = _mm256_set1_epi8(1);
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(have + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(need + i));
+        __m256i ge = _mm256_cmpeq_epi8(_mm256_max_epu8(a, b), a);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_and_si256(ge, one));
+    }
+    return i;
+}
+#endif
+
+// out[i] = have[i] >= need[i]; unsigned byte compare done as max(a, b) == a
+inline void compareLevels(const uint8_t* have, const uint8_t* need, uint8_t* out, size_t n) {
+    size_t i = 0;
+#if defined(ACS_X86)
+    if (hasAvx2()) i = compareLevelsAvx2(have, need, out, n);
+#endif
+#if defined(ACS_HAS_SSE2)
+    const __m128i one16 = _mm_set1_epi8(1);
+    for (; i + 16 <= n; i += 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(have + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(need + i));
+        __m128i ge = _mm_cmpeq_epi8(_mm_max_epu8(a, b), a);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_and_si128(ge, one16));
+    }
+#endif
+    for (; i < n; ++i) out[i] = have[i] >= need[i];
+}
 
-        system.addUser(make_unique<Student>("Ivan Petrov", 1, "CS-101"));
-        system.addUser(make_unique<Teacher>("Anna Volkova", 2, "Mathematics"));
-        system.addUser(make_unique<Administrator>("Dr. Brown", 3, "Dean"));
+// -------------------- Snapshot Format --------------------
 
-        system.addResource(Resource("Library", AccessLevel::Student));
-        system.addResource(Resource("Lab", AccessLevel::Teacher));
-        system.addResource(Resource("Server Room", AccessLevel::Administrator));
+// Binary snapshot, version 2 (native byte order):
+//   SnapshotHeader, then 8-byte aligned sections described by the header:
+//   user records, resource records, id index (keys, slots), user name index
+//   (slots, hashes), resource name index (slots, hashes), interned string bytes.
+// Records are fixed width and refer to names by offset into the string table,
+// so a mapped file is usable as-is without parsing. Version 2 appends the
+// journal generation to the header; version 1 files read as generation 0.
 
-        cout << "\n--- Users ---\n";
-        system.displayAllUsers();
+struct SnapshotSection {
+    uint64_t offset;
+    uint64_t count;
+};
 
-        cout << "\n--- Resources ---\n";
-        system.displayAllResources();
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    SnapshotSection users;
+    SnapshotSection resources;
+    SnapshotSection idKeys;
+    SnapshotSection idSlots;
+    SnapshotSection userNameSlots;
+    SnapshotSection userNameHashes;
+    SnapshotSection resourceNameSlots;
+    SnapshotSection resourceNameHashes;
+    SnapshotSection strings;
+    uint64_t generation;
+};
 
-        cout << "\n--- Access Checks ---\n";
-        cout << "Ivan to Server Room: "
-            << (system.checkAccess(1, "Server Room") ? "Granted" : "Denied") << endl;
+struct SnapshotUser {
+    int32_t id;
+    uint8_t type;
+    uint8_t level;
+    uint16_t reserved;
+    uint32_t nameOffset;
+    uint32_t nameLength;
+    uint32_t extraOffset;
+    uint32_t extraLength;
+};
 
-        cout << "\n--- Sorted Users ---\n";
-        system.sortUsersBy([](const auto& a, const auto& b) {
-            return static_cast<int>(a->getAccessLevel()) < static_cast<int>(b->getAccessLevel());
+struct SnapshotResource {
+    uint32_t nameOffset;
+    uint32_t nameLength;
+    uint8_t level;
+    uint8_t reserved[3];
+};
+
+static_assert(sizeof(SnapshotUser) == 24, "SnapshotUser layout changed");
+static_assert(sizeof(SnapshotResource) == 12, "SnapshotResource layout changed");
+
+constexpr char SNAPSHOT_MAGIC[8] = { 'A', 'C', 'S', 'S', 'N', 'A', 'P', '\0' };
+constexpr uint32_t SNAPSHOT_VERSION = 2;
+constexpr uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304;
+
+// Read-only memory mapping of a whole file
+class MappedFile {
+    const char* data = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#endif
+
+public:
+    explicit MappedFile(const string& filename) {
+#ifdef _WIN32
+        file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) throw runtime_error("Can't open file!");
+        LARGE_INTEGER size;
+        GetFileSizeEx(file, &size);
+        length = static_cast<size_t>(size.QuadPart);
+        if (length > 0) {
+            mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (mapping) data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+            if (!data) {
+                if (mapping) CloseHandle(mapping);
+                CloseHandle(file);
+                throw runtime_error("Can't map file!");
+            }
+        }
+#else
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0) throw runtime_error("Can't open file!");
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            close(fd);
+            throw runtime_error("Can't open file!");
+        }
+        length = static_cast<size_t>(st.st_size);
+        if (length > 0) {
+            void* p = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) {
+                close(fd);
+                throw runtime_error("Can't map file!");
+            }
+            data = static_cast<const char*>(p);
+        }
+        close(fd);
+#endif
+    }
+
+    ~MappedFile() {
+#ifdef _WIN32
+        if (data) UnmapViewOfFile(data);
+        if (mapping) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+#else
+        if (data) munmap(const_cast<char*>(data), length);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* begin() const { return data; }
+    size_t size() const { return length; }
+};
+
+// Snapshot served straight from the mapping: lookups use the prebuilt tables
+class MappedSnapshot {
+    MappedFile file;
+    const SnapshotHeader* header;
+
+    template<typename E>
+    const E* section(const SnapshotSection& s) const {
+        if (s.offset % alignof(E) != 0 || s.offset > file.size()
+            || s.count > (file.size() - s.offset) / sizeof(E))
+            throw runtime_error("Corrupt snapshot");
+        return reinterpret_cast<const E*>(file.begin() + s.offset);
+    }
+
+    // Probing assumes a power-of-two table of at least two buckets (bucket() shifts by
+    // 64 - log2(capacity)) with at least one empty slot, and every other slot must name a
+    // record; anything else would loop, read out of bounds or shift out of range.
+    // Only a snapshot without records may have no table at all.
+    static void checkTable(const uint32_t* slots, size_t capacity, size_t records) {
+        if (capacity == 0) {
+            if (records != 0) throw runtime_error("Corrupt snapshot");
+            return;
+        }
+        if (capacity < 2 || !has_single_bit(capacity)) throw runtime_error("Corrupt snapshot");
+        bool hasEmpty = false;
+        for (size_t i = 0; i < capacity; ++i) {
+            if (slots[i] == IdIndex::npos) hasEmpty = true;
+            else if (slots[i] >= records) throw runtime_error("Corrupt snapshot");
+        }
+        if (!hasEmpty) throw runtime_error("Corrupt snapshot");
+    }
+
+    const SnapshotUser* userRecords;
+    const SnapshotResource* resourceRecords;
+    const int* idKeys;
+    const uint32_t* idSlots;
+    const uint32_t* userNameSlots;
+    const uint32_t* userNameHashes;
+    const uint32_t* resourceNameSlots;
+    const uint32_t* resourceNameHashes;
+    const char* strings;
+
+public:
+    explicit MappedSnapshot(const string& filename) : file(filename) {
+        if (file.size() < offsetof(SnapshotHeader, generation)) throw runtime_error("Corrupt snapshot");
+        header = reinterpret_cast<const SnapshotHeader*>(file.begin());
+        if (memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0)
+            throw runtime_error("Not a snapshot file");
+        if (header->version != 1 && header->version != SNAPSHOT_VERSION)
+            throw runtime_error("Unsupported snapshot version");
+        if (header->version >= 2 && file.size() < sizeof(SnapshotHeader)) throw runtime_error("Corrupt snapshot");
+        if (header->byteOrder != SNAPSHOT_BYTE_ORDER) throw runtime_error("Snapshot byte order mismatch");
+
+        userRecords = section<SnapshotUser>(header->users);
+        resourceRecords = section<SnapshotResource>(header->resources);
+        idKeys = section<int>(header->idKeys);
+        idSlots = section<uint32_t>(header->idSlots);
+        userNameSlots = section<uint32_t>(header->userNameSlots);
+        userNameHashes = section<uint32_t>(header->userNameHashes);
+        resourceNameSlots = section<uint32_t>(header->resourceNameSlots);
+        resourceNameHashes = section<uint32_t>(header->resourceNameHashes);
+        strings = section<char>(header->strings);
+
+        if (header->idKeys.count != header->idSlots.count
+            || header->userNameSlots.count != header->userNameHashes.count
+            || header->resourceNameSlots.count != header->resourceNameHashes.count)
+            throw runtime_error("Corrupt snapshot");
+        checkTable(idSlots, header->idSlots.count, header->users.count);
+        checkTable(userNameSlots, header->userNameSlots.count, header->users.count);
+        checkTable(resourceNameSlots, header->resourceNameSlots.count, header->resources.count);
+
+        // findUser trusts the id table, so every key must be the id of the record it names
+        for (size_t i = 0; i < header->idSlots.count; ++i)
+            if (idSlots[i] != IdIndex::npos && idKeys[i] != userRecords[idSlots[i]].id)
+                throw runtime_error("Corrupt snapshot");
+
+        // Levels are compared as raw bytes by checkAccess, so an out-of-range level
+        // would grant everything; types and levels are checked once here
+        auto validLevel = [](uint8_t level) {
+            return level >= static_cast<uint8_t>(AccessLevel::Student)
+                && level <= static_cast<uint8_t>(AccessLevel::Administrator);
+        };
+        for (size_t i = 0; i < header->users.count; ++i) {
+            const SnapshotUser& r = userRecords[i];
+            if (!validLevel(r.level) || r.type < static_cast<uint8_t>(UserType::Student)
+                || r.type > static_cast<uint8_t>(UserType::Administrator))
+                throw runtime_error("Corrupt snapshot");
+        }
+        for (size_t i = 0; i < header->resources.count; ++i)
+            if (!validLevel(resourceRecords[i].level)) throw runtime_error("Corrupt snapshot");
+    }
+
+    size_t userCount() const { return header->users.count; }
+    size_t resourceCount() const { return header->resources.count; }
+    uint64_t generation() const { return header->version >= 2 ? header->generation : 0; }
+
+    const SnapshotUser& user(uint32_t slot) const { return userRecords[slot]; }
+    const SnapshotResource& resource(uint32_t slot) const { return resourceRecords[slot]; }
+
+    string_view text(uint32_t offset, uint32_t length) const {
+        if (static_cast<uint64_t>(offset) + length > header->strings.count)
+            throw runtime_error("Corrupt snapshot");
+        return string_view(strings + offset, length);
+    }
+
+    string_view userName(uint32_t slot) const {
+        return text(userRecords[slot].nameOffset, userRecords[slot].nameLength);
+    }
+
+    string_view userExtra(uint32_t slot) const {
+        return text(userRecords[slot].extraOffset, userRecords[slot].extraLength);
+    }
+
+    string_view resourceName(uint32_t slot) const {
+        return text(resourceRecords[slot].nameOffset, resourceRecords[slot].nameLength);
+    }
+
+    uint32_t findUser(int id) const {
+        return IdIndex::find(idKeys, idSlots, header->idSlots.count, id);
+    }
+
+    uint32_t findUserByName(string_view name) const {
+        return NameTable::find(userNameSlots, userNameHashes, header->userNameSlots.count, name,
+            [this](uint32_t slot) { return userName(slot); });
+    }
+
+    uint32_t findResource(string_view name) const {
+        return NameTable::find(resourceNameSlots, resourceNameHashes, header->resourceNameSlots.count, name,
+            [this](uint32_t slot) { return resourceName(slot); });
+    }
+
+    bool checkAccess(int userId, string_view resName) const {
+        uint32_t u = findUser(userId);
+        uint32_t r = findResource(resName);
+        return u != IdIndex::npos && r != IdIndex::npos && userRecords[u].level >= resourceRecords[r].level;
+    }
+
+    span<const int> rawIdKeys() const { return { idKeys, header->idKeys.count }; }
+    span<const uint32_t> rawIdSlots() const { return { idSlots, header->idSlots.count }; }
+    span<const uint32_t> rawUserNameSlots() const { return { userNameSlots, header->userNameSlots.count }; }
+    span<const uint32_t> rawUserNameHashes() const { return { userNameHashes, header->userNameHashes.count }; }
+    span<const uint32_t> rawResourceNameSlots() const { return { resourceNameSlots, header->resourceNameSlots.count }; }
+    span<const uint32_t> rawResourceNameHashes() const { return { resourceNameHashes, header->resourceNameHashes.count }; }
+};
+
+// Collects the sections of a snapshot and writes them with the header in front
+class SnapshotWriter {
+    string strings;
+    unordered_map<string_view, uint32_t> interned;
+    vector<pair<SnapshotSection*, pair<const void*, size_t>>> pending;
+    SnapshotHeader header{};
+
+public:
+    SnapshotWriter() {
+        memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+        header.version = SNAPSHOT_VERSION;
+        header.byteOrder = SNAPSHOT_BYTE_ORDER;
+    }
+
+    SnapshotHeader& getHeader() { return header; }
+
+    void reserveStrings(size_t n) { interned.reserve(n); }
+
+    // Equal strings share one copy; views must outlive the writer
+    uint32_t intern(string_view s) {
+        auto it = interned.find(s);
+        if (it != interned.end()) return it->second;
+        if (strings.size() + s.size() > numeric_limits<uint32_t>::max())
+            throw runtime_error("Snapshot string table too large");
+        uint32_t offset = static_cast<uint32_t>(strings.size());
+        strings.append(s);
+        interned.emplace(s, offset);
+        return offset;
+    }
+
+    template<typename E>
+    void add(SnapshotSection& target, span<const E> items) {
+        target.count = items.size();
+        pending.push_back({ &target, { items.data(), items.size_bytes() } });
+    }
+
+    void write(const string& filename) {
+        add(header.strings, span<const char>(strings));
+
+        uint64_t offset = sizeof(SnapshotHeader);
+        for (auto& p : pending) {
+            offset = (offset + 7) & ~uint64_t(7);
+            p.first->offset = offset;
+            offset += p.second.second;
+        }
+
+        ofstream out(filename, ios::binary);
+        if (!out) throw runtime_error("Can't open file!");
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        uint64_t written = sizeof(SnapshotHeader);
+        const char zeros[8] = {};
+        for (auto& p : pending) {
+            out.write(zeros, static_cast<streamsize>(p.first->offset - written));
+            out.write(static_cast<const char*>(p.second.first), static_cast<streamsize>(p.second.second));
+            written = p.first->offset + p.second.second;
+        }
+        if (!out) throw runtime_error("Failed to write snapshot");
+    }
+};
+
+// -------------------- Parallel Loading --------------------
+
+// One line of a data file without its line ending: a trailing '\r' is dropped like
+// text-mode getline on Windows, so CRLF files load the same everywhere. Both loaders use it.
+string_view trimLineEnd(string_view line) {
+    if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+    return line;
+}
+
+// Calls onLine for every non-empty line
+template<typename OnLine>
+void forEachLine(string_view text, OnLine&& onLine) {
+    while (!text.empty()) {
+        size_t pos = text.find('\n');
+        string_view line = trimLineEnd(text.substr(0, pos));
+        text.remove_prefix(pos == string_view::npos ? text.size() : pos + 1);
+        if (!line.empty()) onLine(line);
+    }
+}
+
+// Offset of the first line that is exactly `marker`, or npos
+size_t findLine(string_view text, string_view marker) {
+    for (size_t pos = text.find(marker); pos != string_view::npos; pos = text.find(marker, pos + 1)) {
+        if (pos != 0 && text[pos - 1] != '\n') continue;
+        size_t end = text.find('\n', pos);
+        if (trimLineEnd(text.substr(pos, end == string_view::npos ? end : end - pos)) == marker) return pos;
+    }
+    return string_view::npos;
+}
+
+// Splits text into at most `parts` pieces that each end right after a newline
+vector<string_view> splitAtLines(string_view text, size_t parts) {
+    vector<string_view> chunks;
+    size_t target = text.size() / max<size_t>(parts, 1) + 1;
+    while (!text.empty()) {
+        size_t pos = text.find('\n', min(target, text.size()) - 1);
+        size_t len = pos == string_view::npos ? text.size() : pos + 1;
+        chunks.push_back(text.substr(0, len));
+        text.remove_prefix(len);
+    }
+    return chunks;
+}
+
+// Parses chunks on separate threads into one Part each, then merges the parts in
+// chunk order. Lines equal to `skip` are ignored, as repeated section markers are
+// by loadFromFile.
+template<typename Part, typename Parse, typename Merge>
+Part parseChunks(string_view text, unsigned threads, string_view skip, Parse parse, Merge merge) {
+    vector<future<Part>> parts;
+    for (string_view chunk : splitAtLines(text, threads)) {
+        parts.push_back(async(launch::async, [chunk, skip, &parse] {
+            Part part;
+            forEachLine(chunk, [&](string_view line) {
+                if (line != skip) parse(part, line);
             });
-        system.displayAllUsers();
+            return part;
+        }));
+    }
 
-        system.saveToFile("data.txt");
+    // get() in order rethrows the error of the earliest failing chunk
+    vector<Part> results;
+    for (auto& part : parts) results.push_back(part.get());
 
-        AccessControlSystem<Resource> loadedSystem;
-        loadedSystem.loadFromFile("data.txt");
+    Part merged;
+    for (auto& part : results) merge(merged, move(part));
+    return merged;
+}
 
-        cout << "\n--- Loaded from file ---\n";
-        loadedSystem.displayAllUsers();
-        loadedSystem.displayAllResources();
+// -------------------- Sorting --------------------
+
+// Stable LSD radix sort of slot numbers by 32-bit keys, 8 bits per pass.
+// Passes whose byte is the same for every key are skipped.
+vector<uint32_t> radixSortSlots(const vector<uint32_t>& keys) {
+    size_t n = keys.size();
+    vector<uint32_t> order(n), scratch(n);
+    for (uint32_t i = 0; i < n; ++i) order[i] = i;
+
+    for (unsigned shift = 0; shift < 32; shift += 8) {
+        size_t counts[256] = {};
+        for (uint32_t k : keys) ++counts[(k >> shift) & 0xFF];
+        if (n == 0 || counts[(keys[0] >> shift) & 0xFF] == n) continue;
+
+        size_t sum = 0;
+        for (size_t& c : counts) {
+            size_t current = c;
+            c = sum;
+            sum += current;
+        }
+        for (uint32_t slot : order) scratch[counts[(keys[slot] >> shift) & 0xFF]++] = slot;
+        order.swap(scratch);
+    }
+    return order;
+}
+
+// Slots ordered by name; the first 8 bytes are compared as one big-endian integer
+// so most comparisons never leave the (prefix, slot) array
+template<typename NameOf>
+vector<uint32_t> sortSlotsByName(size_t n, NameOf&& nameOf) {
+    vector<pair<uint64_t, uint32_t>> keyed(n);
+    for (uint32_t i = 0; i < n; ++i) {
+        string_view name = nameOf(i);
+        uint64_t prefix = 0;
+        for (size_t b = 0; b < 8; ++b)
+            prefix = (prefix << 8) | (b < name.size() ? static_cast<uint8_t>(name[b]) : 0);
+        keyed[i] = { prefix, i };
+    }
+    std::sort(keyed.begin(), keyed.end(), [&nameOf](const auto& a, const auto& b) {
+        if (a.first != b.first) return a.first < b.first;
+        int c = nameOf(a.second).compare(nameOf(b.second));
+        return c != 0 ? c < 0 : a.second < b.second;
+    });
+
+    vector<uint32_t> order(n);
+    for (size_t i = 0; i < n; ++i) order[i] = keyed[i].second;
+    return order;
+}
+
+// -------------------- User Storage --------------------
+
+// Storage policies for AccessControlSystem. Users are addressed by dense slot;
+// Handle is what findUserByName returns and Element is what sortUsersBy
+// comparators receive. Both are pointer-like, so callers work with either policy.
+// Handles are read-only: changes go through the system, which keeps its indexes in sync.
+
+// One polymorphic heap object per user (the original layout)
+class PointerUserStore {
+    vector<unique_ptr<User>> users;
+
+public:
+    using Handle = const User*;
+    using Element = unique_ptr<User>;
+
+    size_t size() const { return users.size(); }
+    void clear() { users.clear(); }
+    void reserve(size_t n) { users.reserve(n); }
+
+    int id(uint32_t slot) const { return users[slot]->getId(); }
+    string_view name(uint32_t slot) const { return users[slot]->getName(); }
+    AccessLevel level(uint32_t slot) const { return users[slot]->getAccessLevel(); }
+    UserType type(uint32_t slot) const { return toUserType(users[slot]->getType()); }
+    string_view extra(uint32_t slot) const { return users[slot]->getExtra(); }
+    Handle handle(uint32_t slot) const { return users[slot].get(); }
+
+    void add(unique_ptr<User> user) { users.push_back(move(user)); }
+
+    void add(UserType type, string_view name, int id, AccessLevel level, string_view extra) {
+        users.push_back(makeUser(type, string(name), id, level, string(extra)));
+    }
+
+    void append(PointerUserStore&& other) {
+        if (users.empty()) {
+            users = move(other.users);
+            return;
+        }
+        users.reserve(users.size() + other.users.size());
+        for (auto& u : other.users) users.push_back(move(u));
+    }
+
+    void setLevel(uint32_t slot, AccessLevel level) { users[slot]->setAccessLevel(level); }
+    void setName(uint32_t slot, string_view name) { users[slot]->setName(string(name)); }
+    void setId(uint32_t slot, int id) { users[slot]->setId(id); }
+    void display(uint32_t slot) const { users[slot]->displayInfo(); }
+    string serialize(uint32_t slot) const { return users[slot]->serialize(); }
+
+    template<typename Comp>
+    void sort(Comp&& comp) { std::sort(users.begin(), users.end(), comp); }
+
+    // New slot i holds old slot order[i]
+    void permute(span<const uint32_t> order) {
+        vector<unique_ptr<User>> result(order.size());
+        for (size_t i = 0; i < order.size(); ++i) result[i] = move(users[order[i]]);
+        users = move(result);
+    }
+
+    // Estimate: every heap block is counted with 16 bytes of allocator overhead
+    size_t memoryUsage() const {
+        const size_t overhead = 16;
+        size_t bytes = users.capacity() * sizeof(unique_ptr<User>);
+        for (const auto& u : users) {
+            bytes += sizeof(Student) + overhead;
+            for (const string* s : { &u->getName(), &u->getExtra() })
+                if (s->capacity() > 15) bytes += s->capacity() + 1 + overhead;
+        }
+        return bytes;
+    }
+};
+
+class CompactUserStore;
+
+// Pointer-like view of one user in a CompactUserStore
+class UserRef {
+    const CompactUserStore* store = nullptr;
+    uint32_t slot = 0;
+
+public:
+    UserRef() = default;
+    UserRef(const CompactUserStore* store, uint32_t slot) : store(store), slot(slot) {}
+
+    explicit operator bool() const { return store != nullptr; }
+    const UserRef* operator->() const { return this; }
+    const UserRef& operator*() const { return *this; }
+
+    string_view getName() const;
+    int getId() const;
+    AccessLevel getAccessLevel() const;
+    string getType() const;
+    string_view getExtra() const;
+    void displayInfo() const;
+    string serialize() const;
+};
+
+// Struct-of-arrays users: 8 bytes per user (id and arena offset) plus one record in a
+// shared arena, a varint header followed by the name bytes. The header packs the access
+// level (low two bits) with the index of an interned kind: the type tag byte followed by
+// the type-specific field, which repeats a lot (groups, departments, positions). A record
+// ends where the next slot's begins, so no lengths are stored; a renamed user's record is
+// kept in `renamed` until the next permute packs it back into the arena.
+class CompactUserStore {
+    vector<int> ids;
+    vector<uint32_t> offsets{ 0 };  // record of slot i is names[offsets[i], offsets[i + 1])
+    string names;
+    unordered_map<uint32_t, string> renamed;
+    vector<string> kinds;
+    NameTable kindIndex;
+    string kindKey;
+
+    uint32_t internKind(UserType type, string_view extra) {
+        kindKey.assign(1, static_cast<char>(type));
+        kindKey.append(extra);
+        auto kindAt = [this](uint32_t i) { return string_view(kinds[i]); };
+        uint32_t found = kindIndex.find(kindKey, kindAt);
+        if (found != NameTable::npos) return found;
+        if (kinds.size() >= (1u << 30)) throw length_error("Too many user kinds");
+        kinds.push_back(kindKey);
+        uint32_t index = static_cast<uint32_t>(kinds.size() - 1);
+        kindIndex.insert(kinds.back(), index, kindAt);
+        return index;
+    }
+
+    static void appendHeader(string& out, uint32_t value) {
+        while (value >= 0x80) {
+            out += static_cast<char>((value & 0x7F) | 0x80);
+            value >>= 7;
+        }
+        out += static_cast<char>(value);
+    }
+
+    // Header value (kind << 2 | level) and its width in bytes
+    static uint32_t readHeader(const char* record, size_t& width) {
+        uint32_t value = 0;
+        for (width = 0;; ++width) {
+            auto byte = static_cast<uint8_t>(record[width]);
+            value |= static_cast<uint32_t>(byte & 0x7F) << (7 * width);
+            if (!(byte & 0x80)) {
+                ++width;
+                return value;
+            }
+        }
+    }
+
+    string_view record(uint32_t slot) const {
+        if (!renamed.empty()) {
+            auto it = renamed.find(slot);
+            if (it != renamed.end()) return it->second;
+        }
+        return string_view(names.data() + offsets[slot], offsets[slot + 1] - offsets[slot]);
+    }
+
+    uint32_t header(uint32_t slot) const {
+        size_t width;
+        return readHeader(record(slot).data(), width);
+    }
+
+public:
+    using Handle = UserRef;
+    using Element = UserRef;
+
+    size_t size() const { return ids.size(); }
+
+    void clear() {
+        ids.clear();
+        offsets.assign(1, 0);
+        names.clear();
+        renamed.clear();
+        kinds.clear();
+        kindIndex.clear();
+    }
+
+    void reserve(size_t n) {
+        ids.reserve(n);
+        offsets.reserve(n + 1);
+    }
+
+    int id(uint32_t slot) const { return ids[slot]; }
+    AccessLevel level(uint32_t slot) const { return static_cast<AccessLevel>(header(slot) & 3); }
+    UserType type(uint32_t slot) const { return static_cast<UserType>(kinds[header(slot) >> 2][0]); }
+    string_view extra(uint32_t slot) const { return string_view(kinds[header(slot) >> 2]).substr(1); }
+    Handle handle(uint32_t slot) const { return UserRef(this, slot); }
+
+    string_view name(uint32_t slot) const {
+        string_view rec = record(slot);
+        size_t width;
+        readHeader(rec.data(), width);
+        return rec.substr(width);
+    }
+
+    void add(UserType type, string_view name, int id, AccessLevel level, string_view extra) {
+        if (type < UserType::Student || type > UserType::Administrator) throw invalid_argument("Unknown user type");
+        if (name.empty()) throw EmptyNameException();
+        Validation::checkAccessLevel(level);
+        if (names.size() + name.size() + 5 > numeric_limits<uint32_t>::max()) throw length_error("Name arena is full");
+
+        uint32_t kind = internKind(type, extra);
+        ids.push_back(id);
+        appendHeader(names, kind << 2 | static_cast<uint32_t>(level));
+        names.append(name);
+        offsets.push_back(static_cast<uint32_t>(names.size()));
+    }
+
+    void add(unique_ptr<User> user) {
+        add(toUserType(user->getType()), user->getName(), user->getId(), user->getAccessLevel(), user->getExtra());
+    }
+
+    void append(CompactUserStore&& other) {
+        if (ids.empty()) {
+            *this = move(other);
+            return;
+        }
+        reserve(size() + other.size());
+        for (uint32_t i = 0; i < other.size(); ++i)
+            add(other.type(i), other.name(i), other.id(i), other.level(i), other.extra(i));
+    }
+
+    // The level sits in the low bits of the header, so the header keeps its width
+    void setLevel(uint32_t slot, AccessLevel level) {
+        Validation::checkAccessLevel(level);
+        auto it = renamed.find(slot);
+        char* rec = it != renamed.end() ? it->second.data() : names.data() + offsets[slot];
+        size_t width;
+        uint32_t value = (readHeader(rec, width) & ~3u) | static_cast<uint32_t>(level);
+        string encoded;
+        appendHeader(encoded, value);
+        memcpy(rec, encoded.data(), width);
+    }
+
+    // The old bytes stay in the arena until the next permute
+    void setName(uint32_t slot, string_view name) {
+        if (name.empty()) throw EmptyNameException();
+        string rec;
+        appendHeader(rec, header(slot));
+        rec.append(name);
+        renamed[slot] = move(rec);
+    }
+
+    void setId(uint32_t slot, int id) { ids[slot] = id; }
+
+    void display(uint32_t slot) const { handle(slot).displayInfo(); }
+    string serialize(uint32_t slot) const { return handle(slot).serialize(); }
+
+    // Sorts a slot permutation, then moves every column once
+    template<typename Comp>
+    void sort(Comp&& comp) {
+        vector<uint32_t> order(size());
+        for (uint32_t i = 0; i < order.size(); ++i) order[i] = i;
+        std::sort(order.begin(), order.end(),
+            [&](uint32_t a, uint32_t b) { return comp(handle(a), handle(b)); });
+        permute(order);
+    }
+
+    // Reorders users so that new slot i holds old slot order[i]; also repacks the arena,
+    // folding renamed records back in
+    void permute(span<const uint32_t> order) {
+        vector<int> newIds(order.size());
+        vector<uint32_t> newOffsets(order.size() + 1);
+        string packed;
+        packed.reserve(names.size());
+        for (size_t i = 0; i < order.size(); ++i) {
+            newIds[i] = ids[order[i]];
+            packed.append(record(order[i]));
+            newOffsets[i + 1] = static_cast<uint32_t>(packed.size());
+        }
+        ids = move(newIds);
+        offsets = move(newOffsets);
+        names = move(packed);
+        renamed.clear();
+    }
+
+    // Every renamed record is counted with its map node and 16 bytes of allocator overhead
+    size_t memoryUsage() const {
+        size_t bytes = ids.capacity() * sizeof(int) + offsets.capacity() * sizeof(uint32_t)
+            + names.capacity() + kinds.capacity() * sizeof(string);
+        for (const auto& k : kinds) bytes += k.capacity() > 15 ? k.capacity() + 1 : 0;
+        bytes += renamed.bucket_count() * sizeof(void*);
+        for (const auto& [slot, rec] : renamed)
+            bytes += sizeof(pair<const uint32_t, string>) + 2 * sizeof(void*) + 16 + (rec.capacity() > 15 ? rec.capacity() + 1 : 0);
+        return bytes;
+    }
+};
+
+inline string_view UserRef::getName() const { return store->name(slot); }
+inline int UserRef::getId() const { return store->id(slot); }
+inline AccessLevel UserRef::getAccessLevel() const { return store->level(slot); }
+inline string UserRef::getType() const { return toString(store->type(slot)); }
+inline string_view UserRef::getExtra() const { return store->extra(slot); }
+
+// Same output as the displayInfo overrides, dispatched on the type tag
+inline void UserRef::displayInfo() const {
+    UserType type = store->type(slot);
+    cout << "ID: " << getId() << ", Name: " << getName()
+        << ", Access Level: " << static_cast<int>(getAccessLevel())
+        << ", Type: " << toString(type) << ", " << extraFieldName(type) << ": " << getExtra() << endl;
+}
+
+// Same format as the serialize overrides
+inline string UserRef::serialize() const {
+    string line = getType();
+    line += ',';
+    line += getName();
+    line += ',';
+    line += to_string(getId());
+    line += ',';
+    line += to_string(static_cast<int>(getAccessLevel()));
+    line += ',';
+    line += getExtra();
+    return line;
+}
+
+// -------------------- Access Control System --------------------
+
+// Store selects how users are kept: PointerUserStore (polymorphic objects) or
+// CompactUserStore (struct-of-arrays with type tags)
+template<typename T, typename Store = PointerUserStore>
+class AccessControlSystem {
+    Store users;
+    vector<T> resources;
+
+    IdIndex userById;
+    NameTable userByName;
+    NameTable resourceByName;
+
+    // Decision cache: access levels by slot, so checks never touch User objects.
+    // Every level or id change goes through the system and updates its slot here.
+    vector<uint8_t> userLevels;
+    vector<uint8_t> resourceLevels;
+
+    string_view userNameAt(uint32_t slot) const { return users.name(slot); }
+    string_view resourceNameAt(uint32_t slot) const { return resources[slot].getName(); }
+
+    void indexUser(uint32_t slot) {
+        userById.insert(users.id(slot), slot);
+        userByName.insert(users.name(slot), slot, [this](uint32_t s) { return userNameAt(s); });
+        userLevels[slot] = static_cast<uint8_t>(users.level(slot));
+    }
+
+    void indexResource(uint32_t slot) {
+        resourceByName.insert(resources[slot].getName(), slot, [this](uint32_t s) { return resourceNameAt(s); });
+        resourceLevels[slot] = static_cast<uint8_t>(resources[slot].getRequiredAccessLevel());
+    }
+
+    void rebuildUserIndex() {
+        userById.clear();
+        userByName.clear();
+        userById.reserve(users.size());
+        userByName.reserve(users.size());
+        userLevels.assign(users.size(), 0);
+        for (uint32_t i = 0; i < users.size(); ++i) indexUser(i);
+    }
+
+    void applyUserOrder(const vector<uint32_t>& order) {
+        users.permute(order);
+
+        // Without duplicate ids or names every entry survives the reorder, so the
+        // tables only need their slots renumbered; otherwise "first wins" may change
+        if (userById.size() != users.size() || userByName.size() != users.size()) {
+            rebuildUserIndex();
+            return;
+        }
+        vector<uint32_t> newSlotOf(order.size());
+        vector<uint8_t> levels(order.size());
+        for (uint32_t i = 0; i < order.size(); ++i) {
+            newSlotOf[order[i]] = i;
+            levels[i] = userLevels[order[i]];
+        }
+        userById.remapSlots(newSlotOf);
+        userByName.remapSlots(newSlotOf);
+        userLevels = move(levels);
+    }
+
+    void rebuildResourceIndex() {
+        resourceByName.clear();
+        resourceByName.reserve(resources.size());
+        resourceLevels.assign(resources.size(), 0);
+        for (uint32_t i = 0; i < resources.size(); ++i) indexResource(i);
+    }
+
+    // Replaces the contents with fully parsed data. The indexes are built aside first,
+    // so if that throws the system keeps its previous, consistent state.
+    void adopt(Store&& loadedUsers, vector<T>&& loadedResources) {
+        AccessControlSystem next;
+        next.users = move(loadedUsers);
+        next.resources = move(loadedResources);
+        next.rebuildUserIndex();
+        next.rebuildResourceIndex();
+        *this = move(next);
+    }
+
+public:
+    void addUser(unique_ptr<User> user) {
+        users.add(move(user));
+        userLevels.push_back(0);
+        indexUser(static_cast<uint32_t>(users.size() - 1));
+    }
+
+    void addResource(const T& resource) {
+        resources.push_back(resource);
+        resourceLevels.push_back(0);
+        indexResource(static_cast<uint32_t>(resources.size() - 1));
+    }
+
+    // Changes the level and updates the decision cache for that one user
+    void setUserAccessLevel(int userId, AccessLevel level) {
+        uint32_t slot = userSlot(userId);
+        if (slot == IdIndex::npos) throw invalid_argument("Unknown user id");
+        users.setLevel(slot, level);
+        userLevels[slot] = static_cast<uint8_t>(level);
+    }
+
+    // Renames through the store so the name index stays correct
+    void setUserName(int userId, const string& newName) {
+        uint32_t slot = userSlot(userId);
+        if (slot == IdIndex::npos) throw invalid_argument("Unknown user id");
+        renameSlot(slot, newName);
+    }
+
+    // Same as setUserName, addressed by the current name (the key findUserByName uses)
+    void renameUser(const string& name, const string& newName) {
+        uint32_t slot = userByName.find(name, [this](uint32_t s) { return userNameAt(s); });
+        if (slot == NameTable::npos) throw invalid_argument("Unknown user name");
+        renameSlot(slot, newName);
+    }
+
+    // Moves a user to a new id; the id index is updated in place
+    void changeUserId(int userId, int newId) {
+        uint32_t slot = userSlot(userId);
+        if (slot == IdIndex::npos) throw invalid_argument("Unknown user id");
+        if (newId == userId) return;
+
+        // With duplicate ids "first wins" may move to another user, so rebuild instead
+        bool unique = userById.size() == users.size();
+        users.setId(slot, newId);
+        if (!unique || !userById.erase(userId, slot) || !userById.insert(newId, slot))
+            rebuildUserIndex();
+    }
+
+    uint32_t userSlot(int userId) const {
+        return userById.find(userId);
+    }
+
+private:
+    void renameSlot(uint32_t slot, const string& newName) {
+        Validation::checkName(newName);
+
+        // With duplicate names "first wins" may move to another user, so rebuild instead
+        bool unique = userByName.size() == users.size();
+        string oldName(users.name(slot));
+        users.setName(slot, newName);
+        if (!unique || !userByName.erase(oldName, slot)
+            || !userByName.insert(newName, slot, [this](uint32_t s) { return userNameAt(s); }))
+            rebuildUserIndex();
+    }
+
+public:
+
+    uint32_t resourceSlot(string_view resName) const {
+        return resourceByName.find(resName, [this](uint32_t s) { return resourceNameAt(s); });
+    }
+
+    // Same rule as Resource::checkAccess, answered from the cached levels
+    bool checkAccessBySlot(uint32_t userSlot, uint32_t resSlot) const {
+        return userLevels[userSlot] >= resourceLevels[resSlot];
+    }
+
+    bool checkAccess(int userId, const string& resName) const {
+        uint32_t user = userSlot(userId);
+        uint32_t res = resourceSlot(resName);
+        return user != IdIndex::npos && res != IdIndex::npos && checkAccessBySlot(user, res);
+    }
+
+    // out[i] = 1 if userIds[i] may access resNames[i], 0 otherwise (unknown ids/names deny)
+    void checkAccessBatch(span<const int> userIds, span<const string_view> resNames, span<uint8_t> out) const {
+        if (userIds.size() != resNames.size() || userIds.size() != out.size())
+            throw invalid_argument("Batch spans must have equal size");
+
+        // Unknown users get level 0 and unknown resources 0xFF, so both compare as denied
+        constexpr size_t block = 256;
+        uint8_t have[block];
+        uint8_t need[block];
+        uint32_t res = IdIndex::npos;
+
+        for (size_t base = 0; base < userIds.size(); base += block) {
+            size_t n = min(block, userIds.size() - base);
+            for (size_t j = 0; j < n; ++j) {
+                size_t i = base + j;
+                uint32_t user = userById.find(userIds[i]);
+                have[j] = user != IdIndex::npos ? userLevels[user] : 0;
+
+                // Bursts usually repeat a resource, so reuse the previous lookup
+                if (i == 0 || resNames[i] != resNames[i - 1]) res = resourceSlot(resNames[i]);
+                need[j] = res != IdIndex::npos ? resourceLevels[res] : 0xFF;
+            }
+            compareLevels(have, need, out.data() + base, n);
+        }
+    }
+
+    void displayAllUsers() const {
+        for (uint32_t i = 0; i < users.size(); ++i) users.display(i);
+    }
+
+    void displayAllResources() const {
+        for (const auto& r : resources) r.displayInfo();
+    }
+
+    // Bytes held by the user storage itself, without indexes and caches
+    size_t userMemoryUsage() const {
+        return users.memoryUsage();
+    }
+
+    // Read-only handle; use setUserName/renameUser, changeUserId and setUserAccessLevel to modify
+    typename Store::Handle findUserByName(const string& name) const {
+        uint32_t slot = userByName.find(name, [this](uint32_t s) { return userNameAt(s); });
+        return slot != NameTable::npos ? users.handle(slot) : typename Store::Handle();
+    }
+
+    // comp receives two Store::Element values; any callable works, including std::function
+    template<typename Comp>
+    void sortUsersBy(Comp&& comp) {
+        users.sort(comp);
+        rebuildUserIndex();
+    }
+
+    // Key-extracting sorts: keys are gathered once, slots are sorted by key and the
+    // store is permuted in a single pass. Ties keep their current order.
+    void sortUsersById() {
+        vector<uint32_t> keys(users.size());
+        for (uint32_t i = 0; i < keys.size(); ++i)
+            keys[i] = static_cast<uint32_t>(users.id(i)) ^ 0x80000000u;  // signed order as unsigned
+        applyUserOrder(radixSortSlots(keys));
+    }
+
+    void sortUsersByLevel() {
+        vector<uint32_t> keys(userLevels.begin(), userLevels.end());
+        applyUserOrder(radixSortSlots(keys));
+    }
+
+    void sortUsersByName() {
+        applyUserOrder(sortSlotsByName(users.size(), [this](uint32_t s) { return users.name(s); }));
+    }
+
+    void saveToFile(const string& filename) const {
+        ofstream out(filename);
+        if (!out) throw runtime_error("Can't open file!");
+
+        for (uint32_t i = 0; i < users.size(); ++i) out << users.serialize(i) << "\n";
+
+        out << "RESOURCES\n";
+        for (const auto& r : resources) out << r.serialize() << "\n";
+    }
+
+    void loadFromFile(const string& filename) {
+        ifstream in(filename);
+        if (!in) throw runtime_error("Can't open file!");
+
+        // Parsed into locals so a bad line leaves the current contents untouched
+        Store loadedUsers;
+        vector<T> loadedResources;
+        string line;
+        bool readingResources = false;
+        while (getline(in, line)) {
+            string_view view = trimLineEnd(line);
+            if (view.empty()) continue;
+            if (view == "RESOURCES") {
+                readingResources = true;
+                continue;
+            }
+
+            if (!readingResources) {
+                UserFields f = parseUserLine(view);
+                loadedUsers.add(f.type, f.name, f.id, f.level, f.extra);
+            }
+            else
+                loadedResources.push_back(T::deserialize(string(view)));
+        }
+
+        adopt(move(loadedUsers), move(loadedResources));
+    }
+
+    // Same result as loadFromFile; the file is mapped, split into newline-aligned
+    // chunks and each chunk is parsed on its own thread
+    void loadFromFileParallel(const string& filename, unsigned threads = thread::hardware_concurrency()) {
+        MappedFile file(filename);
+        string_view text = file.size() ? string_view(file.begin(), file.size()) : string_view();
+        threads = max(threads, 1u);
+
+        // The first RESOURCES line splits the file; later ones are skipped like in loadFromFile
+        const string_view marker = "RESOURCES";
+        size_t boundary = findLine(text, marker);
+        string_view userText = text.substr(0, boundary);
+        string_view resourceText = boundary == string_view::npos ? string_view() : text.substr(boundary);
+
+        auto loadedUsers = parseChunks<Store>(userText, threads, marker,
+            [](Store& part, string_view line) {
+                UserFields f = parseUserLine(line);
+                part.add(f.type, f.name, f.id, f.level, f.extra);
+            },
+            [](Store& merged, Store&& part) { merged.append(move(part)); });
+        auto loadedResources = parseChunks<vector<T>>(resourceText, threads, marker,
+            [](vector<T>& part, string_view line) { part.push_back(T::deserialize(string(line))); },
+            [](vector<T>& merged, vector<T>&& part) {
+                merged.insert(merged.end(), make_move_iterator(part.begin()), make_move_iterator(part.end()));
+            });
+
+        adopt(move(loadedUsers), move(loadedResources));
+    }
+
+    // Binary snapshot with prebuilt indexes; see "Snapshot Format" above
+    void saveSnapshot(const string& filename, uint64_t generation = 0) const {
+        SnapshotWriter writer;
+        writer.reserveStrings(users.size() * 2 + resources.size());
+
+        vector<SnapshotUser> userRecords(users.size());
+        for (uint32_t i = 0; i < users.size(); ++i) {
+            SnapshotUser& r = userRecords[i];
+            r.id = users.id(i);
+            r.type = static_cast<uint8_t>(users.type(i));
+            r.level = userLevels[i];
+            r.nameOffset = writer.intern(users.name(i));
+            r.nameLength = static_cast<uint32_t>(users.name(i).size());
+            r.extraOffset = writer.intern(users.extra(i));
+            r.extraLength = static_cast<uint32_t>(users.extra(i).size());
+        }
+
+        vector<SnapshotResource> resourceRecords(resources.size());
+        for (size_t i = 0; i < resources.size(); ++i) {
+            SnapshotResource& r = resourceRecords[i];
+            r.nameOffset = writer.intern(resources[i].getName());
+            r.nameLength = static_cast<uint32_t>(resources[i].getName().size());
+            r.level = resourceLevels[i];
+        }
+
+        SnapshotHeader& h = writer.getHeader();
+        h.generation = generation;
+        writer.add(h.users, span<const SnapshotUser>(userRecords));
+        writer.add(h.resources, span<const SnapshotResource>(resourceRecords));
+        writer.add(h.idKeys, userById.rawKeys());
+        writer.add(h.idSlots, userById.rawSlots());
+        writer.add(h.userNameSlots, userByName.rawSlots());
+        writer.add(h.userNameHashes, userByName.rawHashes());
+        writer.add(h.resourceNameSlots, resourceByName.rawSlots());
+        writer.add(h.resourceNameHashes, resourceByName.rawHashes());
+        writer.write(filename);
+    }
+
+    // Materializes users and resources from a mapped snapshot and adopts its indexes as-is.
+    // Returns the generation stored in the snapshot.
+    uint64_t loadSnapshot(const string& filename) {
+        MappedSnapshot snap(filename);
+
+        // Everything is built aside and swapped in at the end, like in loadFromFile
+        Store loadedUsers;
+        vector<T> loadedResources;
+        vector<uint8_t> loadedUserLevels(snap.userCount());
+        vector<uint8_t> loadedResourceLevels(snap.resourceCount());
+        loadedUsers.reserve(snap.userCount());
+        loadedResources.reserve(snap.resourceCount());
+
+        for (uint32_t i = 0; i < snap.userCount(); ++i) {
+            const SnapshotUser& r = snap.user(i);
+            loadedUsers.add(static_cast<UserType>(r.type), snap.userName(i), r.id, static_cast<AccessLevel>(r.level), snap.userExtra(i));
+            loadedUserLevels[i] = r.level;
+        }
+        for (uint32_t i = 0; i < snap.resourceCount(); ++i) {
+            const SnapshotResource& r = snap.resource(i);
+            loadedResources.push_back(T(string(snap.resourceName(i)), fromInt(r.level)));
+            loadedResourceLevels[i] = r.level;
+        }
+
+        IdIndex ids;
+        NameTable userNames;
+        NameTable resourceNames;
+        ids.assign(snap.rawIdKeys(), snap.rawIdSlots());
+        userNames.assign(snap.rawUserNameSlots(), snap.rawUserNameHashes());
+        resourceNames.assign(snap.rawResourceNameSlots(), snap.rawResourceNameHashes());
+
+        users = move(loadedUsers);
+        resources = move(loadedResources);
+        userLevels = move(loadedUserLevels);
+        resourceLevels = move(loadedResourceLevels);
+        userById = move(ids);
+        userByName = move(userNames);
+        resourceByName = move(resourceNames);
+        return snap.generation();
+    }
+};
+
+// -------------------- Concurrent Access Control --------------------
+
+// Epoch-based reclamation shared by all concurrent systems. A reader announces the
+// global epoch in its own cache line while it holds a state; a writer frees a
+// retired state once no announced epoch is older than the state's retire epoch.
+class EpochReclaimer {
+public:
+    static constexpr size_t MAX_READERS = 256;
+
+    static EpochReclaimer& instance() {
+        static EpochReclaimer reclaimer;
+        return reclaimer;
+    }
+
+    // Marks the calling thread as reading; nests, and never blocks or allocates after the first use
+    class Guard {
+    public:
+        Guard() { threadSlot().enter(); }
+        ~Guard() { threadSlot().leave(); }
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+    };
+
+    // Called by writers after publishing a new state; returns the retire epoch for the old one
+    uint64_t advance() {
+        return globalEpoch.fetch_add(1) + 1;
+    }
+
+    // Oldest epoch still announced by a reader, or UINT64_MAX when nobody reads
+    uint64_t oldestActiveEpoch() const {
+        uint64_t oldest = numeric_limits<uint64_t>::max();
+        for (const Slot& s : slots) {
+            uint64_t e = s.epoch.load();
+            if (e != 0 && e < oldest) oldest = e;
+        }
+        return oldest;
+    }
+
+private:
+    struct alignas(64) Slot {
+        atomic<uint64_t> epoch{ 0 };
+        atomic<bool> used{ false };
+    };
+
+    Slot slots[MAX_READERS];
+    atomic<uint64_t> globalEpoch{ 1 };
+
+    struct ThreadSlot {
+        size_t index = MAX_READERS;
+        unsigned depth = 0;
+
+        void enter() {
+            EpochReclaimer& r = instance();
+            if (index == MAX_READERS) index = r.claimSlot();
+            if (depth++ == 0) r.slots[index].epoch.store(r.globalEpoch.load());
+        }
+
+        void leave() {
+            if (--depth == 0) instance().slots[index].epoch.store(0);
+        }
+
+        ~ThreadSlot() {
+            if (index != MAX_READERS) instance().slots[index].used.store(false);
+        }
+    };
+
+    static ThreadSlot& threadSlot() {
+        thread_local ThreadSlot slot;
+        return slot;
+    }
+
+    size_t claimSlot() {
+        for (size_t i = 0; i < MAX_READERS; ++i) {
+            bool expected = false;
+            if (!slots[i].used.load() && slots[i].used.compare_exchange_strong(expected, true)) return i;
+        }
+        throw runtime_error("Too many reader threads");
+    }
+};
+
+// Thread-safe AccessControlSystem: reads run lock-free against an immutable state,
+// writes are collected in a WriteBatch, applied to a copy of the state and published
+// with one atomic pointer swap. A commit costs a copy of the state, so group writes.
+template<typename T>
+class ConcurrentAccessControlSystem {
+public:
+    using State = AccessControlSystem<T, CompactUserStore>;
+
+    class WriteBatch {
+        friend class ConcurrentAccessControlSystem;
+
+        enum class Kind { AddUser, AddResource, SetLevel };
+
+        struct Op {
+            Kind kind;
+            unique_ptr<User> user;
+            optional<T> resource;
+            int userId = 0;
+            AccessLevel level = AccessLevel::Student;
+        };
+
+        vector<Op> ops;
+
+    public:
+        void addUser(unique_ptr<User> user) {
+            ops.push_back({ Kind::AddUser, move(user), nullopt });
+        }
+
+        void addResource(const T& resource) {
+            ops.push_back({ Kind::AddResource, nullptr, resource });
+        }
+
+        void setUserAccessLevel(int userId, AccessLevel level) {
+            ops.push_back({ Kind::SetLevel, nullptr, nullopt, userId, level });
+        }
+
+        bool empty() const { return ops.empty(); }
+        size_t size() const { return ops.size(); }
+    };
+
+private:
+    atomic<const State*> current;
+    mutex writerMutex;
+    vector<pair<const State*, uint64_t>> retired;
+
+    void reclaim() {
+        uint64_t oldest = EpochReclaimer::instance().oldestActiveEpoch();
+        auto keep = remove_if(retired.begin(), retired.end(), [oldest](const auto& r) {
+            if (r.second > oldest) return false;
+            delete r.first;
+            return true;
+        });
+        retired.erase(keep, retired.end());
+    }
+
+public:
+    ConcurrentAccessControlSystem() : current(new State()) {}
+
+    // Readers must be gone by now
+    ~ConcurrentAccessControlSystem() {
+        delete current.load();
+        for (auto& r : retired) delete r.first;
+    }
+
+    ConcurrentAccessControlSystem(const ConcurrentAccessControlSystem&) = delete;
+    ConcurrentAccessControlSystem& operator=(const ConcurrentAccessControlSystem&) = delete;
+
+    // Runs f on a consistent state; nothing obtained from the state may escape f
+    template<typename F>
+    auto read(F&& f) const {
+        EpochReclaimer::Guard guard;
+        return f(*current.load());
+    }
+
+    bool checkAccess(int userId, const string& resName) const {
+        return read([&](const State& s) { return s.checkAccess(userId, resName); });
+    }
+
+    void checkAccessBatch(span<const int> userIds, span<const string_view> resNames, span<uint8_t> out) const {
+        read([&](const State& s) { s.checkAccessBatch(userIds, resNames, out); });
+    }
+
+    optional<int> findUserIdByName(const string& name) const {
+        return read([&](const State& s) -> optional<int> {
+            auto user = s.findUserByName(name);
+            return user ? optional<int>(user->getId()) : nullopt;
+        });
+    }
+
+    // All operations of the batch become visible together, or none if one throws
+    void commit(WriteBatch batch) {
+        if (batch.empty()) return;
+        lock_guard<mutex> lock(writerMutex);
+
+        auto next = make_unique<State>(*current.load());
+        for (auto& op : batch.ops) {
+            switch (op.kind) {
+            case WriteBatch::Kind::AddUser: next->addUser(move(op.user)); break;
+            case WriteBatch::Kind::AddResource: next->addResource(*op.resource); break;
+            case WriteBatch::Kind::SetLevel: next->setUserAccessLevel(op.userId, op.level); break;
+            }
+        }
+
+        const State* old = current.exchange(next.release());
+        retired.push_back({ old, EpochReclaimer::instance().advance() });
+        reclaim();
+    }
+
+    void addUser(unique_ptr<User> user) {
+        WriteBatch batch;
+        batch.addUser(move(user));
+        commit(move(batch));
+    }
+
+    void addResource(const T& resource) {
+        WriteBatch batch;
+        batch.addResource(resource);
+        commit(move(batch));
+    }
+
+    void setUserAccessLevel(int userId, AccessLevel level) {
+        WriteBatch batch;
+        batch.setUserAccessLevel(userId, level);
+        commit(move(batch));
+    }
+};
+
+// -------------------- Journal --------------------
+
+// Journal file: JournalHeader, then records
+//   u32 payload length, u32 FNV-1a checksum of op and payload, u8 op, payload
+// Payloads (native byte order):
+//   AddUser      i32 id, u8 type, u8 level, u32 name length, u32 extra length, name, extra
+//   SetName      i32 id, u32 name length, name
+//   SetLevel     i32 id, u8 level
+//   AddResource  u8 level, u32 name length, name
+// A torn or corrupt tail, left by a crash in the middle of an append, ends replay
+// and is cut off. The generation must match the snapshot the journal continues.
+
+struct JournalHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint64_t generation;
+};
+
+enum class JournalOp : uint8_t {
+    AddUser = 1,
+    SetName = 2,
+    SetLevel = 3,
+    AddResource = 4
+};
+
+constexpr char JOURNAL_MAGIC[8] = { 'A', 'C', 'S', 'J', 'R', 'N', 'L', '\0' };
+constexpr uint32_t JOURNAL_VERSION = 1;
+constexpr size_t JOURNAL_RECORD_HEADER = 9;
+
+// Write-only file opened for appending, with an explicit fsync
+class AppendFile {
+    int fd = -1;
+
+public:
+    AppendFile(const string& filename, bool truncate) {
+#ifdef _WIN32
+        int flags = _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY | (truncate ? _O_TRUNC : 0);
+        fd = _open(filename.c_str(), flags, _S_IREAD | _S_IWRITE);
+#else
+        int flags = O_WRONLY | O_CREAT | O_APPEND | (truncate ? O_TRUNC : 0);
+        fd = open(filename.c_str(), flags, 0644);
+#endif
+        if (fd < 0) throw runtime_error("Can't open file!");
+    }
+
+    ~AppendFile() {
+#ifdef _WIN32
+        _close(fd);
+#else
+        close(fd);
+#endif
+    }
+
+    AppendFile(const AppendFile&) = delete;
+    AppendFile& operator=(const AppendFile&) = delete;
+
+    void write(string_view data) {
+        while (!data.empty()) {
+#ifdef _WIN32
+            int n = _write(fd, data.data(), static_cast<unsigned>(min<size_t>(data.size(), 1u << 30)));
+#else
+            ssize_t n = ::write(fd, data.data(), data.size());
+#endif
+            if (n <= 0) throw runtime_error("Journal write failed");
+            data.remove_prefix(static_cast<size_t>(n));
+        }
+    }
+
+    void sync() {
+#ifdef _WIN32
+        if (_commit(fd) != 0) throw runtime_error("Journal sync failed");
+#else
+        if (fsync(fd) != 0) throw runtime_error("Journal sync failed");
+#endif
+    }
+};
+
+// Makes a rename inside the directory of path durable (no-op on Windows, where the
+// rename itself is journaled by NTFS)
+inline void syncDirectory(const string& path) {
+#ifndef _WIN32
+    string dir = filesystem::path(path).parent_path().string();
+    int fd = open(dir.empty() ? "." : dir.c_str(), O_RDONLY);
+    if (fd < 0) throw runtime_error("Can't open directory!");
+    int result = fsync(fd);
+    close(fd);
+    if (result != 0) throw runtime_error("Directory sync failed");
+#else
+    (void)path;
+#endif
+}
+
+template<typename V>
+void appendRaw(string& out, V value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+inline void appendText(string& out, string_view text) {
+    appendRaw(out, static_cast<uint32_t>(text.size()));
+    out.append(text);
+}
+
+// Bounds-checked reader over one record payload
+class JournalReader {
+    string_view rest;
+
+public:
+    explicit JournalReader(string_view payload) : rest(payload) {}
+
+    template<typename V>
+    V raw() {
+        if (rest.size() < sizeof(V)) throw runtime_error("Corrupt journal record");
+        V value;
+        memcpy(&value, rest.data(), sizeof(V));
+        rest.remove_prefix(sizeof(V));
+        return value;
+    }
+
+    string_view text(uint32_t length) {
+        if (rest.size() < length) throw runtime_error("Corrupt journal record");
+        string_view t = rest.substr(0, length);
+        rest.remove_prefix(length);
+        return t;
+    }
+};
+
+// AccessControlSystem persisted as snapshot + append-only journal. Mutations are
+// validated, logged as compact records and only then applied; records are written
+// and fsynced in groups (every groupCommit records, or on sync()). compact() folds
+// the journal into a new snapshot. Reads go through view().
+template<typename T, typename Store = PointerUserStore>
+class PersistentAccessControlSystem {
+    AccessControlSystem<T, Store> system;
+    string snapshotFile;
+    string journalFile;
+    unique_ptr<AppendFile> journal;
+    uint64_t generation = 0;
+    string pending;
+    size_t pendingRecords = 0;
+    size_t groupCommit;
+    uintmax_t durableSize = 0;
+
+    // Buffers a record and syncs the group once it is full. If that sync fails the
+    // record is taken back, so the caller must not apply the change.
+    void log(JournalOp op, string_view payload) {
+        size_t mark = pending.size();
+        appendRaw(pending, static_cast<uint32_t>(payload.size()));
+        size_t checksumAt = pending.size();
+        appendRaw(pending, uint32_t(0));
+        pending += static_cast<char>(op);
+        pending.append(payload);
+        uint32_t checksum = NameTable::hashName(string_view(pending).substr(checksumAt + 4));
+        memcpy(&pending[checksumAt], &checksum, sizeof(checksum));
+        if (++pendingRecords < groupCommit) return;
+        try {
+            sync();
+        }
+        catch (...) {
+            pending.resize(mark);
+            --pendingRecords;
+            throw;
+        }
+    }
+
+    void checkUser(int userId) const {
+        if (system.userSlot(userId) == IdIndex::npos) throw invalid_argument("Unknown user id");
+    }
+
+    void startJournal() {
+        journal.reset();
+        journal = make_unique<AppendFile>(journalFile, true);
+        JournalHeader header{};
+        memcpy(header.magic, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC));
+        header.version = JOURNAL_VERSION;
+        header.byteOrder = SNAPSHOT_BYTE_ORDER;
+        header.generation = generation;
+        journal->write(string_view(reinterpret_cast<const char*>(&header), sizeof(header)));
+        journal->sync();
+        durableSize = sizeof(header);
+    }
+
+    void apply(JournalOp op, string_view payload) {
+        JournalReader in(payload);
+        switch (op) {
+        case JournalOp::AddUser: {
+            int id = in.raw<int32_t>();
+            auto type = static_cast<UserType>(in.raw<uint8_t>());
+            auto level = fromInt(in.raw<uint8_t>());
+            uint32_t nameLength = in.raw<uint32_t>();
+            uint32_t extraLength = in.raw<uint32_t>();
+            string_view name = in.text(nameLength);
+            string_view extra = in.text(extraLength);
+            system.addUser(makeUser(type, string(name), id, level, string(extra)));
+            break;
+        }
+        case JournalOp::SetName: {
+            int id = in.raw<int32_t>();
+            string_view name = in.text(in.raw<uint32_t>());
+            system.setUserName(id, string(name));
+            break;
+        }
+        case JournalOp::SetLevel: {
+            int id = in.raw<int32_t>();
+            system.setUserAccessLevel(id, fromInt(in.raw<uint8_t>()));
+            break;
+        }
+        case JournalOp::AddResource: {
+            auto level = fromInt(in.raw<uint8_t>());
+            string_view name = in.text(in.raw<uint32_t>());
+            system.addResource(T(string(name), level));
+            break;
+        }
+        default:
+            throw runtime_error("Corrupt journal record");
+        }
+    }
+
+    // Replays records of a journal that continues the loaded snapshot; false if it does not
+    bool replay() {
+        size_t valid = 0;
+        {
+            MappedFile file(journalFile);
+            string_view text = file.size() ? string_view(file.begin(), file.size()) : string_view();
+            if (text.size() < sizeof(JournalHeader)) return false;
+            JournalHeader header;
+            memcpy(&header, text.data(), sizeof(header));
+            if (memcmp(header.magic, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) != 0)
+                throw runtime_error("Not a journal file");
+            if (header.version != JOURNAL_VERSION || header.byteOrder != SNAPSHOT_BYTE_ORDER)
+                throw runtime_error("Unsupported journal version");
+            if (header.generation != generation) return false;
+
+            valid = sizeof(JournalHeader);
+            while (text.size() - valid >= JOURNAL_RECORD_HEADER) {
+                uint32_t length, checksum;
+                memcpy(&length, text.data() + valid, sizeof(length));
+                memcpy(&checksum, text.data() + valid + 4, sizeof(checksum));
+                if (text.size() - valid - JOURNAL_RECORD_HEADER < length) break;
+                string_view body = text.substr(valid + 8, 1 + length);
+                if (NameTable::hashName(body) != checksum) break;
+                apply(static_cast<JournalOp>(body[0]), body.substr(1));
+                valid += JOURNAL_RECORD_HEADER + length;
+            }
+        }
+        if (valid != filesystem::file_size(journalFile)) filesystem::resize_file(journalFile, valid);
+        durableSize = valid;
+        return true;
+    }
+
+public:
+    // Loads the snapshot if there is one, replays the journal written after it and
+    // keeps the journal open for appending
+    PersistentAccessControlSystem(string snapshotFile, string journalFile, size_t groupCommit = 64)
+        : snapshotFile(move(snapshotFile)), journalFile(move(journalFile)), groupCommit(max<size_t>(groupCommit, 1)) {
+        if (filesystem::exists(this->snapshotFile)) generation = system.loadSnapshot(this->snapshotFile);
+
+        // A journal from an older generation was already folded into the snapshot
+        if (filesystem::exists(this->journalFile) && replay())
+            journal = make_unique<AppendFile>(this->journalFile, false);
+        else
+            startJournal();
+    }
+
+    ~PersistentAccessControlSystem() {
+        try {
+            sync();
+        }
+        catch (const exception& e) {
+            cerr << "Journal error: " << e.what() << endl;
+        }
+    }
+
+    PersistentAccessControlSystem(const PersistentAccessControlSystem&) = delete;
+    PersistentAccessControlSystem& operator=(const PersistentAccessControlSystem&) = delete;
+
+    const AccessControlSystem<T, Store>& view() const { return system; }
+
+    void addUser(unique_ptr<User> user) {
+        string payload;
+        appendRaw(payload, static_cast<int32_t>(user->getId()));
+        appendRaw(payload, static_cast<uint8_t>(toUserType(user->getType())));
+        appendRaw(payload, static_cast<uint8_t>(user->getAccessLevel()));
+        appendRaw(payload, static_cast<uint32_t>(user->getName().size()));
+        appendRaw(payload, static_cast<uint32_t>(user->getExtra().size()));
+        payload += user->getName();
+        payload += user->getExtra();
+        log(JournalOp::AddUser, payload);
+        system.addUser(move(user));
+    }
+
+    void setUserName(int userId, const string& newName) {
+        checkUser(userId);
+        Validation::checkName(newName);
+        string payload;
+        appendRaw(payload, static_cast<int32_t>(userId));
+        appendText(payload, newName);
+        log(JournalOp::SetName, payload);
+        system.setUserName(userId, newName);
+    }
+
+    void setUserAccessLevel(int userId, AccessLevel level) {
+        checkUser(userId);
+        Validation::checkAccessLevel(level);
+        string payload;
+        appendRaw(payload, static_cast<int32_t>(userId));
+        appendRaw(payload, static_cast<uint8_t>(level));
+        log(JournalOp::SetLevel, payload);
+        system.setUserAccessLevel(userId, level);
+    }
+
+    void addResource(const T& resource) {
+        string payload;
+        appendRaw(payload, static_cast<uint8_t>(resource.getRequiredAccessLevel()));
+        appendText(payload, resource.getName());
+        log(JournalOp::AddResource, payload);
+        system.addResource(resource);
+    }
+
+    // Writes buffered records with one write() and makes them durable. On failure
+    // the journal is cut back to its last durable size, so a retry does not leave
+    // a torn or duplicated group behind.
+    void sync() {
+        if (pendingRecords == 0) return;
+        try {
+            journal->write(pending);
+            journal->sync();
+        }
+        catch (...) {
+            error_code ignored;
+            filesystem::resize_file(journalFile, durableSize, ignored);
+            throw;
+        }
+        durableSize += pending.size();
+        pending.clear();
+        pendingRecords = 0;
+    }
+
+    // Writes the whole state as the next snapshot generation and starts an empty journal.
+    // The snapshot is renamed into place (and the directory synced) first, so a crash
+    // leaves either the old pair or a new snapshot with a stale journal that the next
+    // load ignores.
+    void compact() {
+        sync();
+        string tmp = snapshotFile + ".tmp";
+        system.saveSnapshot(tmp, generation + 1);
+        AppendFile(tmp, false).sync();
+        filesystem::rename(tmp, snapshotFile);
+        syncDirectory(snapshotFile);
+        ++generation;
+        startJournal();
+    }
+};
+
+// -------------------- Benchmarks --------------------
+
+// Average checkAccess latency for growing user counts; flat numbers mean O(1) lookups
+void benchmarkCheckAccess(size_t maxUsers) {
+    const size_t queries = 1'000'000;
+    const string resNames[] = { "Library", "Lab", "Server Room" };
+
+    for (size_t n = 1000; n <= maxUsers; n *= 10) {
+        AccessControlSystem<Resource> system;
+        system.addResource(Resource("Library", AccessLevel::Student));
+        system.addResource(Resource("Lab", AccessLevel::Teacher));
+        system.addResource(Resource("Server Room", AccessLevel::Administrator));
+        for (size_t i = 0; i < n; ++i)
+            system.addUser(make_unique<Student>("User" + to_string(i), static_cast<int>(i), "G-1"));
+
+        uint64_t seed = 42;
+        size_t granted = 0;
+        auto start = chrono::steady_clock::now();
+        for (size_t q = 0; q < queries; ++q) {
+            seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+            int id = static_cast<int>((seed >> 33) % n);
+            granted += system.checkAccess(id, resNames[q % 3]);
+        }
+        auto elapsed = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+
+        cout << "users: " << n << ", checkAccess: " << elapsed / queries
+            << " ns/op (granted " << granted << ")" << endl;
+    }
+}
+
+// Per-call checkAccess against checkAccessBatch over the same queries
+void benchmarkCheckAccessBatch(size_t userCount) {
+    const size_t queries = 1'000'000;
+    const string_view resNames[] = { "Library", "Lab", "Server Room" };
+
+    AccessControlSystem<Resource> system;
+    system.addResource(Resource("Library", AccessLevel::Student));
+    system.addResource(Resource("Lab", AccessLevel::Teacher));
+    system.addResource(Resource("Server Room", AccessLevel::Administrator));
+    for (size_t i = 0; i < userCount; ++i)
+        system.addUser(make_unique<Student>("User" + to_string(i), static_cast<int>(i), "G-1"));
+
+    vector<int> ids(queries);
+    vector<string_view> names(queries);
+    vector<string> nameStrings(queries);
+    uint64_t seed = 42;
+    for (size_t q = 0; q < queries; ++q) {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        ids[q] = static_cast<int>((seed >> 33) % (userCount + userCount / 10));
+        names[q] = resNames[(q / 64) % 3];
+        nameStrings[q] = string(names[q]);
+    }
+
+    size_t granted = 0;
+    auto start = chrono::steady_clock::now();
+    for (size_t q = 0; q < queries; ++q) granted += system.checkAccess(ids[q], nameStrings[q]);
+    auto single = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+
+    vector<uint8_t> out(queries);
+    start = chrono::steady_clock::now();
+    system.checkAccessBatch(ids, names, out);
+    auto batch = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+
+    size_t batchGranted = 0;
+    for (uint8_t v : out) batchGranted += v;
+
+    cout << "users: " << userCount << ", checkAccess: " << single / queries << " ns/op (granted " << granted
+        << "), checkAccessBatch: " << batch / queries << " ns/op (granted " << batchGranted << ")" << endl;
+}
+
+// CSV save/load against binary snapshot save/load and opening the mapping alone
+void benchmarkSnapshot(size_t userCount) {
+    AccessControlSystem<Resource> system;
+    system.addResource(Resource("Library", AccessLevel::Student));
+    system.addResource(Resource("Lab", AccessLevel::Teacher));
+    system.addResource(Resource("Server Room", AccessLevel::Administrator));
+    for (size_t i = 0; i < userCount; ++i)
+        system.addUser(make_unique<Student>("User" + to_string(i), static_cast<int>(i), "G-" + to_string(i % 100)));
+
+    auto time = [](auto&& action) {
+        auto start = chrono::steady_clock::now();
+        action();
+        return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    };
+
+    AccessControlSystem<Resource> loaded;
+    double csvSave = time([&] { system.saveToFile("bench_users.txt"); });
+    double csvLoad = time([&] { loaded.loadFromFile("bench_users.txt"); });
+    double binSave = time([&] { system.saveSnapshot("bench_users.bin"); });
+    double binLoad = time([&] { loaded.loadSnapshot("bench_users.bin"); });
+    bool granted = false;
+    double mapOpen = time([&] {
+        MappedSnapshot snap("bench_users.bin");
+        granted = snap.checkAccess(static_cast<int>(userCount / 2), "Library");
+    });
+
+    cout << "users: " << userCount << "\n"
+        << "CSV save: " << csvSave << " ms, CSV load: " << csvLoad << " ms\n"
+        << "snapshot save: " << binSave << " ms, snapshot load: " << binLoad << " ms\n"
+        << "mapped open + first check: " << mapOpen << " ms (" << (granted ? "Granted" : "Denied") << ")" << endl;
+
+    remove("bench_users.txt");
+    remove("bench_users.bin");
+}
+
+// The stringstream/vector<string> parser that User::deserialize used to be
+unique_ptr<User> legacyDeserialize(const string& line) {
+    stringstream ss(line);
+    vector<string> tokens;
+    string token;
+    while (getline(ss, token, ',')) tokens.push_back(token);
+
+    if (tokens.size() < 5) throw invalid_argument("Invalid user format");
+
+    string type = tokens[0];
+    string name = tokens[1];
+    int id = stoi(tokens[2]);
+    AccessLevel level = fromInt(stoi(tokens[3]));
+    string extra = tokens[4];
+
+    return makeUser(toUserType(type), name, id, level, extra);
+}
+
+// Lines/sec and MB/s of the legacy parser, User::deserialize and the bare tokenizer
+void benchmarkParse(size_t megabytes) {
+    const char* types[] = { "Student,", "Teacher,", "Administrator," };
+    const char* extras[] = { "CS-101", "Mathematics", "Dean" };
+    string data;
+    data.reserve(megabytes * 1024 * 1024 + 128);
+    for (size_t i = 0; data.size() < megabytes * 1024 * 1024; ++i) {
+        size_t t = i % 3;
+        data += types[t];
+        data += "User Number ";
+        data += to_string(i);
+        data += ',';
+        data += to_string(i);
+        data += ',';
+        data += to_string(t + 1);
+        data += ',';
+        data += extras[t];
+        data += '\n';
+    }
+
+    auto run = [&](const char* label, auto&& parseLine) {
+        size_t lines = 0;
+        size_t checksum = 0;
+        auto start = chrono::steady_clock::now();
+        string_view rest = data;
+        while (!rest.empty()) {
+            size_t pos = rest.find('\n');
+            string_view line = rest.substr(0, pos);
+            rest.remove_prefix(pos == string_view::npos ? rest.size() : pos + 1);
+            checksum += parseLine(line);
+            ++lines;
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << label << ": " << lines / seconds / 1e6 << " M lines/s, "
+            << data.size() / seconds / (1024 * 1024) << " MB/s (checksum " << checksum << ")" << endl;
+    };
+
+    cout << "input: " << data.size() / (1024 * 1024) << " MB" << endl;
+    run("legacy deserialize", [](string_view line) {
+        return static_cast<size_t>(legacyDeserialize(string(line))->getId());
+    });
+    run("User::deserialize", [](string_view line) {
+        return static_cast<size_t>(User::deserialize(line)->getId());
+    });
+    run("parseUserFields", [](string_view line) {
+        UserFields f;
+        return parseUserFields(line, f) == ParseError::None ? static_cast<size_t>(f.id) : 0;
+    });
+}
+
+// True if loadFromFile and loadFromFileParallel produce the same saved file
+bool loadersAgree(const string& filename) {
+    AccessControlSystem<Resource> serial, parallel;
+    serial.loadFromFile(filename);
+    parallel.loadFromFileParallel(filename);
+    serial.saveToFile("bench_serial.txt");
+    parallel.saveToFile("bench_parallel.txt");
+    auto contents = [](const char* name) {
+        ifstream in(name, ios::binary);
+        return string(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+    };
+    bool same = contents("bench_serial.txt") == contents("bench_parallel.txt");
+    remove("bench_serial.txt");
+    remove("bench_parallel.txt");
+    return same;
+}
+
+// Single-threaded loadFromFile against loadFromFileParallel on the same CSV file,
+// plus a check that both agree on it and on a CRLF copy
+void benchmarkLoad(size_t userCount) {
+    auto write = [&](const char* filename, const char* eol) {
+        ofstream out(filename, ios::binary);
+        for (size_t i = 0; i < userCount; ++i)
+            out << "Student,User " << i << "," << i << ",1,G-" << i % 100 << eol;
+        out << "RESOURCES" << eol << "Library,1" << eol << "Lab,2" << eol << "Server Room,3" << eol;
+    };
+    write("bench_users.txt", "\n");
+
+    auto time = [](auto&& action) {
+        auto start = chrono::steady_clock::now();
+        action();
+        return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    };
+
+    AccessControlSystem<Resource> serial, parallel;
+    double serialMs = time([&] { serial.loadFromFile("bench_users.txt"); });
+    double parallelMs = time([&] { parallel.loadFromFileParallel("bench_users.txt"); });
+    bool same = loadersAgree("bench_users.txt");
+    write("bench_users_crlf.txt", "\r\n");
+    bool sameCrlf = loadersAgree("bench_users_crlf.txt");
+
+    cout << "users: " << userCount << ", threads: " << thread::hardware_concurrency()
+        << ", loadFromFile: " << serialMs << " ms, loadFromFileParallel: " << parallelMs << " ms"
+        << (same ? "" : " (results differ!)") << (sameCrlf ? "" : " (CRLF results differ!)") << endl;
+
+    remove("bench_users.txt");
+    remove("bench_users_crlf.txt");
+}
+
+// Memory per user, sortUsersBy and a full serialize scan for one storage policy
+template<typename Store>
+void benchmarkStore(const char* label, size_t userCount) {
+    const char* groups[] = { "CS-101", "CS-102", "Mathematics", "Dean" };
+    AccessControlSystem<Resource, Store> system;
+    for (size_t i = 0; i < userCount; ++i) {
+        // Scatter levels so the sort has real work to do
+        size_t k = (i * 2654435761u) % userCount;
+        string name = "User Number " + to_string(k);
+        if (k % 3 == 0) system.addUser(make_unique<Student>(name, static_cast<int>(k), groups[k % 2]));
+        else if (k % 3 == 1) system.addUser(make_unique<Teacher>(name, static_cast<int>(k), groups[2]));
+        else system.addUser(make_unique<Administrator>(name, static_cast<int>(k), groups[3]));
+    }
+
+    auto time = [](auto&& action) {
+        auto start = chrono::steady_clock::now();
+        action();
+        return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    };
+
+    double sortMs = time([&] {
+        system.sortUsersBy([](const auto& a, const auto& b) {
+            return static_cast<int>(a->getAccessLevel()) < static_cast<int>(b->getAccessLevel());
+            });
+    });
+    double scanMs = time([&] { system.saveToFile("bench_users.txt"); });
+    remove("bench_users.txt");
+
+    cout << label << ": " << static_cast<double>(system.userMemoryUsage()) / userCount << " bytes/user, sort by level: "
+        << sortMs << " ms, serialize all: " << scanMs << " ms" << endl;
+}
+
+// Comparator sorts (type-erased and inlined) against the key-extracting sorts
+template<typename Store>
+void benchmarkSort(const char* label, size_t userCount) {
+    AccessControlSystem<Resource, Store> system;
+    for (size_t i = 0; i < userCount; ++i) {
+        size_t k = (i * 2654435761u) % userCount;
+        system.addUser(make_unique<Teacher>("User Number " + to_string(k), static_cast<int>(k), "Mathematics"));
+        system.setUserAccessLevel(static_cast<int>(k), fromInt(static_cast<int>(k % 3) + 1));
+    }
+
+    auto time = [](auto&& action) {
+        auto start = chrono::steady_clock::now();
+        action();
+        return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    };
+    using Element = typename Store::Element;
+    auto byId = [](const Element& a, const Element& b) { return a->getId() < b->getId(); };
+    auto scramble = [&] { system.sortUsersByName(); };
+
+    double erased = time([&] { system.sortUsersBy(function<bool(const Element&, const Element&)>(byId)); });
+    scramble();
+    double inlined = time([&] { system.sortUsersBy(byId); });
+    scramble();
+    double radixId = time([&] { system.sortUsersById(); });
+    double radixLevel = time([&] { system.sortUsersByLevel(); });
+    double byName = time([&] { system.sortUsersByName(); });
+
+    cout << label << ", " << userCount << " users (ms): by id std::function " << erased << ", by id lambda " << inlined
+        << ", sortUsersById " << radixId << ", sortUsersByLevel " << radixLevel << ", sortUsersByName " << byName << endl;
+}
+
+// Readers hammer checkAccess/findUserIdByName while a writer commits batches.
+// Each batch adds users 2k and 2k+1 and promotes 2k to Administrator, so a reader
+// that sees one of them without the other (or 2k without the promotion) saw a torn write.
+bool runConcurrentStressTest(unsigned readerCount, chrono::milliseconds duration) {
+    ConcurrentAccessControlSystem<Resource> system;
+    system.addResource(Resource("Server Room", AccessLevel::Administrator));
+
+    atomic<bool> stop{ false };
+    atomic<int> committedPairs{ 0 };
+    atomic<size_t> violations{ 0 };
+    atomic<size_t> reads{ 0 };
+
+    vector<thread> readers;
+    for (unsigned t = 0; t < readerCount; ++t) {
+        readers.emplace_back([&, t] {
+            uint64_t seed = 1234 + t;
+            size_t local = 0;
+            while (!stop.load(memory_order_relaxed)) {
+                seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+                int k = static_cast<int>((seed >> 33) % (committedPairs.load() + 8));
+                bool ok = system.read([&](const auto& s) {
+                    bool first = s.userSlot(2 * k) != IdIndex::npos;
+                    bool second = s.userSlot(2 * k + 1) != IdIndex::npos;
+                    return first == second && (!first || s.checkAccess(2 * k, "Server Room"));
+                });
+                auto byName = system.findUserIdByName("User " + to_string(2 * k + 1));
+                if (!ok || (byName && *byName != 2 * k + 1)) violations.fetch_add(1);
+                ++local;
+            }
+            reads.fetch_add(local);
+        });
+    }
+
+    auto end = chrono::steady_clock::now() + duration;
+    for (int k = 0; chrono::steady_clock::now() < end; ++k) {
+        ConcurrentAccessControlSystem<Resource>::WriteBatch batch;
+        batch.addUser(make_unique<Student>("User " + to_string(2 * k), 2 * k, "G-1"));
+        batch.addUser(make_unique<Student>("User " + to_string(2 * k + 1), 2 * k + 1, "G-1"));
+        batch.setUserAccessLevel(2 * k, AccessLevel::Administrator);
+        system.commit(move(batch));
+        committedPairs.store(k + 1);
+    }
+    stop = true;
+    for (auto& r : readers) r.join();
+
+    cout << "readers: " << readerCount << ", commits: " << committedPairs.load() << ", reads: " << reads.load()
+        << ", violations: " << violations.load() << endl;
+    return violations.load() == 0;
+}
+
+// Total and per-thread checkAccess throughput for 1..N reader threads with a writer committing in the background
+void benchmarkConcurrentReads(size_t userCount) {
+    ConcurrentAccessControlSystem<Resource> system;
+    {
+        ConcurrentAccessControlSystem<Resource>::WriteBatch batch;
+        batch.addResource(Resource("Library", AccessLevel::Student));
+        batch.addResource(Resource("Server Room", AccessLevel::Administrator));
+        for (size_t i = 0; i < userCount; ++i)
+            batch.addUser(make_unique<Student>("User" + to_string(i), static_cast<int>(i), "G-1"));
+        system.commit(move(batch));
+    }
+
+    // 1, 2, 4, ... and then the core count itself, which need not be a power of two
+    unsigned maxThreads = max(1u, thread::hardware_concurrency());
+    vector<unsigned> threadCounts;
+    for (unsigned threads = 1; threads < maxThreads; threads *= 2) threadCounts.push_back(threads);
+    threadCounts.push_back(maxThreads);
+
+    for (unsigned threads : threadCounts) {
+        atomic<bool> stop{ false };
+        atomic<size_t> total{ 0 };
+        atomic<size_t> totalGranted{ 0 };
+        vector<thread> readers;
+        for (unsigned t = 0; t < threads; ++t) {
+            readers.emplace_back([&, t] {
+                uint64_t seed = 99 + t;
+                size_t local = 0, granted = 0;
+                while (!stop.load(memory_order_relaxed)) {
+                    seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+                    granted += system.checkAccess(static_cast<int>((seed >> 33) % userCount), "Library");
+                    ++local;
+                }
+                total.fetch_add(local);
+                totalGranted.fetch_add(granted);
+            });
+        }
+
+        // One small batch per millisecond keeps the readers racing against publications
+        const auto duration = chrono::milliseconds(500);
+        auto end = chrono::steady_clock::now() + duration;
+        int nextId = static_cast<int>(userCount);
+        while (chrono::steady_clock::now() < end) {
+            system.setUserAccessLevel(nextId % static_cast<int>(userCount), AccessLevel::Teacher);
+            ++nextId;
+            this_thread::sleep_for(chrono::milliseconds(1));
+        }
+        stop = true;
+        for (auto& r : readers) r.join();
+
+        double perSecond = total.load() / chrono::duration<double>(duration).count();
+        cout << "threads: " << threads << ", reads: " << perSecond / 1e6 << " M/s total, "
+            << perSecond / threads / 1e6 << " M/s per thread, granted: "
+            << (total.load() ? 100.0 * totalGranted.load() / total.load() : 0) << "%" << endl;
+    }
+}
+
+// Bytes and time to persist a stream of single-user changes: full CSV rewrite per
+// change, journal with fsync per change, and journal with group commit
+void benchmarkJournal(size_t userCount) {
+    const int changes = 200;
+    remove("bench.snap");
+    remove("bench.journal");
+
+    AccessControlSystem<Resource> full;
+    {
+        PersistentAccessControlSystem<Resource> seed("bench.snap", "bench.journal");
+        seed.addResource(Resource("Library", AccessLevel::Student));
+        for (size_t i = 0; i < userCount; ++i) {
+            seed.addUser(make_unique<Student>("User" + to_string(i), static_cast<int>(i), "G-1"));
+            full.addUser(make_unique<Student>("User" + to_string(i), static_cast<int>(i), "G-1"));
+        }
+        seed.compact();
+    }
+
+    auto time = [](auto&& action) {
+        auto start = chrono::steady_clock::now();
+        action();
+        return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    };
+
+    uintmax_t rewriteBytes = 0;
+    double rewriteMs = time([&] {
+        for (int c = 0; c < changes; ++c) {
+            full.setUserAccessLevel(c, AccessLevel::Teacher);
+            full.saveToFile("bench_users.txt");
+            rewriteBytes += filesystem::file_size("bench_users.txt");
+        }
+    });
+    remove("bench_users.txt");
+
+    auto journaled = [&](size_t group) {
+        PersistentAccessControlSystem<Resource> system("bench.snap", "bench.journal", group);
+        uintmax_t before = filesystem::file_size("bench.journal");
+        double ms = time([&] {
+            for (int c = 0; c < changes; ++c) system.setUserAccessLevel(c, AccessLevel::Teacher);
+            system.sync();
+        });
+        uintmax_t bytes = filesystem::file_size("bench.journal") - before;
+        system.compact();
+        return make_pair(ms, bytes);
+    };
+    auto perChange = journaled(1);
+    auto grouped = journaled(64);
+
+    cout << "users: " << userCount << ", changes: " << changes << "\n"
+        << "full rewrite: " << rewriteMs << " ms, " << rewriteBytes << " bytes\n"
+        << "journal, fsync per change: " << perChange.first << " ms, " << perChange.second << " bytes\n"
+        << "journal, group commit of 64: " << grouped.first << " ms, " << grouped.second << " bytes" << endl;
+
+    remove("bench.snap");
+    remove("bench.journal");
+}
+
+// -------------------- Main --------------------
+
+int main(int argc, char* argv[]) {
+    try {
+        if (argc > 2 && string(argv[1]) == "--bench") {
+            string name = argv[2];
+            if (name == "lookup") {
+                benchmarkCheckAccess(argc > 3 ? stoul(argv[3]) : 10'000'000);
+                return 0;
+            }
+            if (name == "batch") {
+                benchmarkCheckAccessBatch(argc > 3 ? stoul(argv[3]) : 1'000'000);
+                return 0;
+            }
+            if (name == "parse") {
+                benchmarkParse(argc > 3 ? stoul(argv[3]) : 1024);
+                return 0;
+            }
+            if (name == "load") {
+                benchmarkLoad(argc > 3 ? stoul(argv[3]) : 1'000'000);
+                return 0;
+            }
+            if (name == "storage") {
+                size_t count = argc > 3 ? stoul(argv[3]) : 1'000'000;
+                benchmarkStore<PointerUserStore>("PointerUserStore", count);
+                benchmarkStore<CompactUserStore>("CompactUserStore", count);
+                return 0;
+            }
+            if (name == "sort") {
+                size_t count = argc > 3 ? stoul(argv[3]) : 1'000'000;
+                benchmarkSort<PointerUserStore>("PointerUserStore", count);
+                benchmarkSort<CompactUserStore>("CompactUserStore", count);
+                return 0;
+            }
+            if (name == "concurrent") {
+                benchmarkConcurrentReads(argc > 3 ? stoul(argv[3]) : 100'000);
+                return 0;
+            }
+            if (name == "journal") {
+                benchmarkJournal(argc > 3 ? stoul(argv[3]) : 100'000);
+                return 0;
+            }
+            if (name == "snapshot") {
+                benchmarkSnapshot(argc > 3 ? stoul(argv[3]) : 1'000'000);
+                return 0;
+            }
+            throw invalid_argument("Unknown benchmark: " + name);
+        }
+        if (argc > 1 && string(argv[1]) == "--stress") {
+            unsigned readers = argc > 2 ? static_cast<unsigned>(stoul(argv[2])) : max(2u, thread::hardware_concurrency());
+            return runConcurrentStressTest(readers, chrono::seconds(2)) ? 0 : 1;
+        }
+
+        AccessControlSystem<Resource> system;
+
+        system.addUser(make_unique<Student>("Ivan Petrov", 1, "CS-101"));
+        system.addUser(make_unique<Teacher>("Anna Volkova", 2, "Mathematics"));
+        system.addUser(make_unique<Administrator>("Dr. Brown", 3, "Dean"));
+
+        system.addResource(Resource("Library", AccessLevel::Student));
+        system.addResource(Resource("Lab", AccessLevel::Teacher));
+        system.addResource(Resource("Server Room", AccessLevel::Administrator));
+
+        cout << "\n--- Users ---\n";
+        system.displayAllUsers();
+
+        cout << "\n--- Resources ---\n";
+        system.displayAllResources();
+
+        cout << "\n--- Access Checks ---\n";
+        cout << "Ivan to Server Room: "
+            << (system.checkAccess(1, "Server Room") ? "Granted" : "Denied") << endl;
+
+        cout << "\n--- Sorted Users ---\n";
+        system.sortUsersBy([](const auto& a, const auto& b) {
+            return static_cast<int>(a->getAccessLevel()) < static_cast<int>(b->getAccessLevel());
+            });
+        system.displayAllUsers();
+
+        system.saveToFile("data.txt");
+
+        AccessControlSystem<Resource> loadedSystem;
+        loadedSystem.loadFromFileParallel("data.txt");
+
+        cout << "\n--- Loaded from file ---\n";
+        loadedSystem.displayAllUsers();
+        loadedSystem.displayAllResources();
+
+        system.saveSnapshot("data.bin");
+
+        AccessControlSystem<Resource> snapshotSystem;
+        snapshotSystem.loadSnapshot("data.bin");
+
+        cout << "\n--- Loaded from snapshot ---\n";
+        snapshotSystem.displayAllUsers();
+        snapshotSystem.displayAllResources();
+
+        AccessControlSystem<Resource, CompactUserStore> compactSystem;
+        compactSystem.loadFromFile("data.txt");
+
+        cout << "\n--- Compact storage ---\n";
+        compactSystem.displayAllUsers();
+        if (auto user = compactSystem.findUserByName("Anna Volkova"))
+            cout << "Found " << user->getName() << " with ID " << user->getId() << endl;
+
+        MappedSnapshot snapshot("data.bin");
+        cout << "Anna to Lab (mapped): "
+            << (snapshot.checkAccess(2, "Lab") ? "Granted" : "Denied") << endl;
 
     }
     catch (const exception& e) {
@@ -2,9 +2,25 @@
 #include <queue>
 #include <string>
 #include <stdexcept>  
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+
+// Режим очереди: обычная однопоточная или один производитель и один потребитель
+struct SingleThreaded {};
+struct SingleProducerSingleConsumer {};
 
 // Шаблонный класс
-template <typename T>
+template <typename T, typename Mode = SingleThreaded>
 class Queue {
 private:
     std::queue<T> data;
@@ -41,8 +57,572 @@ public:
     }
 };
 
+// ==== Потокобезопасная очередь ====
+
+inline constexpr std::size_t CACHE_LINE = 64;
+
+// Ограниченная очередь без блокировок для многих производителей и потребителей (схема Вьюкова).
+// У каждой ячейки есть номер sequence: для позиции pos ячейка свободна, когда sequence == pos,
+// и заполнена, когда sequence == pos + 1. Позиции записи и чтения захватываются CAS
+// и лежат на разных кэш-линиях. Вместо печати методы возвращают результат.
+// Захваченную ячейку нельзя ни вернуть, ни пропустить, поэтому между CAS и публикацией
+// не должно быть исключений: в ячейку только перемещают (noexcept), а копии делаются
+// до захвата.
+template <typename T>
+class ConcurrentQueue {
+    static_assert(std::is_nothrow_move_constructible_v<T> && std::is_nothrow_destructible_v<T>,
+        "ConcurrentQueue needs a noexcept move constructor and destructor");
+
+private:
+    struct Cell {
+        std::atomic<std::size_t> sequence;
+        alignas(T) unsigned char storage[sizeof(T)];
+
+        T* value() { return std::launder(reinterpret_cast<T*>(storage)); }
+    };
+
+    std::size_t mask;
+    std::unique_ptr<Cell[]> cells;
+    alignas(CACHE_LINE) std::atomic<std::size_t> tail{ 0 };  // следующая позиция записи
+    alignas(CACHE_LINE) std::atomic<std::size_t> head{ 0 };  // следующая позиция чтения
+    alignas(CACHE_LINE) std::atomic<unsigned> waiters{ 0 };  // потоки в push() / pop(), ждущие ячейку
+
+    static std::size_t roundUp(std::size_t capacity) {
+        if (capacity == 0) {
+            throw std::invalid_argument("Queue capacity must be positive.");
+        }
+        std::size_t size = 2;
+        while (size < capacity) size *= 2;
+        return size;
+    }
+
+    // Захватывает до n готовых ячеек подряд с позиции position. Готовая ячейка для записи
+    // имеет sequence == pos, для чтения - pos + 1 (ready = 0 или 1). Возвращает число
+    // захваченных ячеек, 0 - если очередь полна (пуста).
+    std::size_t claim(std::atomic<std::size_t>& position, std::size_t ready, std::size_t n, std::size_t& first) {
+        std::size_t pos = position.load(std::memory_order_relaxed);
+        for (;;) {
+            std::size_t seq = cells[pos & mask].sequence.load(std::memory_order_acquire);
+            std::ptrdiff_t dif = static_cast<std::ptrdiff_t>(seq - (pos + ready));
+            if (dif < 0) return 0;
+            if (dif > 0) {  // позицию уже забрал другой поток
+                pos = position.load(std::memory_order_relaxed);
+                continue;
+            }
+
+            // Свободные (заполненные) ячейки за pos может захватить только тот, кто сдвинет position
+            std::size_t k = 1;
+            while (k < n && k <= mask
+                && cells[(pos + k) & mask].sequence.load(std::memory_order_acquire) == pos + k + ready) {
+                ++k;
+            }
+            if (position.compare_exchange_weak(pos, pos + k, std::memory_order_relaxed)) {
+                first = pos;
+                return k;
+            }
+        }
+    }
+
+    // Будит ждущих у ячеек first .. first + k - 1 после их публикации. Барьер seq_cst в паре
+    // с seq_cst в waitAt: либо ждущий увидит новое значение ячейки, либо здесь будет видно
+    // ждущего. Без ждущих notify не вызывается; на пакет нужен один барьер.
+    void wakeWaiters(std::size_t first, std::size_t k) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters.load(std::memory_order_relaxed) > 0) {
+            for (std::size_t i = 0; i < k; ++i) cells[(first + i) & mask].sequence.notify_all();
+        }
+    }
+
+    template <typename Source>
+    std::size_t pushFrom(Source&& take, std::size_t n) {
+        std::size_t first;
+        std::size_t k = claim(tail, 0, n, first);
+        for (std::size_t i = 0; i < k; ++i) {
+            Cell& cell = cells[(first + i) & mask];
+            ::new (static_cast<void*>(cell.storage)) T(take(i));
+            cell.sequence.store(first + i + 1, std::memory_order_release);
+        }
+        if (k > 0) wakeWaiters(first, k);
+        return k;
+    }
+
+    template <typename Sink>
+    std::size_t popInto(Sink&& put, std::size_t n) {
+        std::size_t first;
+        std::size_t k = claim(head, 1, n, first);
+        for (std::size_t i = 0; i < k; ++i) {
+            Cell& cell = cells[(first + i) & mask];
+            put(i, std::move(*cell.value()));
+            cell.value()->~T();
+            cell.sequence.store(first + i + mask + 1, std::memory_order_release);
+        }
+        if (k > 0) wakeWaiters(first, k);
+        return k;
+    }
+
+    // Ждёт, пока ячейка на позиции position не сменит состояние
+    void waitAt(const std::atomic<std::size_t>& position, std::size_t ready) {
+        waiters.fetch_add(1, std::memory_order_seq_cst);
+        std::size_t pos = position.load(std::memory_order_relaxed);
+        Cell& cell = cells[pos & mask];
+        std::size_t seq = cell.sequence.load(std::memory_order_seq_cst);
+        if (static_cast<std::ptrdiff_t>(seq - (pos + ready)) < 0) {
+            cell.sequence.wait(seq, std::memory_order_acquire);
+        }
+        waiters.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+public:
+    // Ёмкость округляется вверх до степени двойки
+    explicit ConcurrentQueue(std::size_t capacity)
+        : mask(roundUp(capacity) - 1), cells(new Cell[mask + 1]) {
+        for (std::size_t i = 0; i <= mask; ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ConcurrentQueue(const ConcurrentQueue&) = delete;
+    ConcurrentQueue& operator=(const ConcurrentQueue&) = delete;
+
+    ~ConcurrentQueue() {
+        for (std::size_t pos = head.load(std::memory_order_relaxed); pos != tail.load(std::memory_order_relaxed); ++pos) {
+            Cell& cell = cells[pos & mask];
+            if (cell.sequence.load(std::memory_order_relaxed) == pos + 1) cell.value()->~T();
+        }
+    }
+
+    // Неблокирующие операции: false / пусто, если очередь полна / пуста
+    bool tryPush(const T& item) {
+        if constexpr (std::is_nothrow_copy_constructible_v<T>) {
+            return pushFrom([&](std::size_t) -> const T& { return item; }, 1) == 1;
+        }
+        else {
+            T copy(item);
+            return tryPush(std::move(copy));
+        }
+    }
+
+    bool tryPush(T&& item) {
+        return pushFrom([&](std::size_t) -> T&& { return std::move(item); }, 1) == 1;
+    }
+
+    std::optional<T> tryPop() {
+        std::optional<T> result;
+        popInto([&](std::size_t, T&& item) { result.emplace(std::move(item)); }, 1);
+        return result;
+    }
+
+    // Пакетные операции: одним CAS захватывают до n ячеек, возвращают число переданных.
+    // Если копирование T может бросить, элементы копируются и добавляются по одному.
+    std::size_t tryPushN(const T* items, std::size_t n) {
+        if constexpr (std::is_nothrow_copy_constructible_v<T>) {
+            return pushFrom([&](std::size_t i) -> const T& { return items[i]; }, n);
+        }
+        else {
+            std::size_t pushed = 0;
+            while (pushed < n && tryPush(items[pushed])) ++pushed;
+            return pushed;
+        }
+    }
+
+    std::size_t tryPopN(T* out, std::size_t n) {
+        static_assert(std::is_nothrow_move_assignable_v<T>, "tryPopN needs a noexcept move assignment");
+        return popInto([&](std::size_t i, T&& item) { out[i] = std::move(item); }, n);
+    }
+
+    // Блокирующие операции: ждут места (элемента), не нагружая процессор
+    void push(T item) {
+        while (!tryPush(std::move(item))) {
+            waitAt(tail, 0);
+        }
+    }
+
+    T pop() {
+        for (;;) {
+            if (std::optional<T> item = tryPop()) return std::move(*item);
+            waitAt(head, 1);
+        }
+    }
+
+    std::size_t capacity() const {
+        return mask + 1;
+    }
+
+    // Приблизительно: при одновременных операциях результат может сразу устареть
+    bool isEmpty() const {
+        return head.load(std::memory_order_acquire) >= tail.load(std::memory_order_acquire);
+    }
+};
+
+// Очередь для одного производителя и одного потребителя: без CAS и без мьютекса.
+// Каждая сторона пишет только свой индекс и держит копию чужого, которую перечитывает,
+// лишь когда по копии очередь кажется полной (пустой). Ёмкость - степень двойки.
+// Как и у обычной Queue, извлечение из пустой очереди - ошибка: pop() бросает исключение,
+// tryPop() возвращает пустое значение.
+template <typename T>
+class Queue<T, SingleProducerSingleConsumer> {
+private:
+    struct Slot {
+        alignas(T) unsigned char storage[sizeof(T)];
+
+        T* value() { return std::launder(reinterpret_cast<T*>(storage)); }
+    };
+
+    std::size_t mask;
+    std::unique_ptr<Slot[]> slots;
+
+    // Кэш-линия производителя
+    alignas(CACHE_LINE) std::atomic<std::size_t> tail{ 0 };
+    std::size_t cachedHead = 0;
+
+    // Кэш-линия потребителя
+    alignas(CACHE_LINE) std::atomic<std::size_t> head{ 0 };
+    std::size_t cachedTail = 0;
+
+    static std::size_t roundUp(std::size_t capacity) {
+        if (capacity == 0) {
+            throw std::invalid_argument("Queue capacity must be positive.");
+        }
+        std::size_t size = 1;
+        while (size < capacity) size *= 2;
+        return size;
+    }
+
+    // Конструирует до n элементов из get(i) и публикует их одним store. Если конструктор
+    // бросает исключение, уже созданные элементы уничтожаются, а tail не сдвигается.
+    template <typename Get>
+    std::size_t pushFrom(Get&& get, std::size_t n) {
+        std::size_t t = tail.load(std::memory_order_relaxed);
+        std::size_t free = mask + 1 - (t - cachedHead);
+        if (free < n) {
+            cachedHead = head.load(std::memory_order_acquire);
+            free = mask + 1 - (t - cachedHead);
+        }
+        std::size_t k = std::min(n, free);
+        std::size_t i = 0;
+        try {
+            for (; i < k; ++i) {
+                ::new (static_cast<void*>(slots[(t + i) & mask].storage)) T(get(i));
+            }
+        }
+        catch (...) {
+            while (i > 0) slots[(t + --i) & mask].value()->~T();
+            throw;
+        }
+        tail.store(t + k, std::memory_order_release);
+        return k;
+    }
+
+public:
+    // Ёмкость округляется вверх до степени двойки
+    explicit Queue(std::size_t capacity)
+        : mask(roundUp(capacity) - 1), slots(new Slot[mask + 1]) {
+    }
+
+    Queue(const Queue&) = delete;
+    Queue& operator=(const Queue&) = delete;
+
+    ~Queue() {
+        for (std::size_t i = head.load(std::memory_order_relaxed); i != tail.load(std::memory_order_relaxed); ++i) {
+            slots[i & mask].value()->~T();
+        }
+    }
+
+    // Только из потока производителя. Возвращает, сколько из n элементов поместилось.
+    std::size_t pushN(const T* items, std::size_t n) {
+        return pushFrom([&](std::size_t i) -> const T& { return items[i]; }, n);
+    }
+
+    // Только из потока потребителя. Возвращает, сколько элементов извлечено (до n).
+    // Если присваивание бросает исключение, извлечёнными считаются элементы до него.
+    std::size_t popN(T* out, std::size_t n) {
+        std::size_t h = head.load(std::memory_order_relaxed);
+        std::size_t available = cachedTail - h;
+        if (available < n) {
+            cachedTail = tail.load(std::memory_order_acquire);
+            available = cachedTail - h;
+        }
+        std::size_t k = std::min(n, available);
+        std::size_t i = 0;
+        try {
+            for (; i < k; ++i) {
+                T* item = slots[(h + i) & mask].value();
+                out[i] = std::move(*item);
+                item->~T();
+            }
+        }
+        catch (...) {
+            head.store(h + i, std::memory_order_release);
+            throw;
+        }
+        head.store(h + k, std::memory_order_release);
+        return k;
+    }
+
+    bool tryPush(const T& item) {
+        return pushN(&item, 1) == 1;
+    }
+
+    bool tryPush(T&& item) {
+        return pushFrom([&](std::size_t) -> T&& { return std::move(item); }, 1) == 1;
+    }
+
+    std::optional<T> tryPop() {
+        std::size_t h = head.load(std::memory_order_relaxed);
+        if (cachedTail == h) {
+            cachedTail = tail.load(std::memory_order_acquire);
+            if (cachedTail == h) return std::nullopt;
+        }
+        T* item = slots[h & mask].value();
+        std::optional<T> result(std::move(*item));
+        item->~T();
+        head.store(h + 1, std::memory_order_release);
+        return result;
+    }
+
+    void push(const T& item) {
+        if (!tryPush(item)) {
+            throw std::runtime_error("Attempt to push to a full queue.");
+        }
+    }
+
+    T pop() {
+        std::optional<T> item = tryPop();
+        if (!item) {
+            throw std::runtime_error("Attempt to pop from an empty queue.");
+        }
+        return std::move(*item);
+    }
+
+    // Точно только для потребителя; остальным - приблизительно
+    bool isEmpty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+
+    std::size_t capacity() const {
+        return mask + 1;
+    }
+};
+
+template <typename T>
+using SpscQueue = Queue<T, SingleProducerSingleConsumer>;
+
+// ==== Сравнение очередей ====
+
+// Обычная очередь под мьютексом с той же ёмкостью - точка отсчёта для сравнения
+template <typename T>
+class LockedQueue {
+private:
+    std::mutex mutex;
+    std::queue<T> data;
+    std::size_t limit;
+
+public:
+    explicit LockedQueue(std::size_t capacity) : limit(capacity) {}
+
+    bool tryPush(const T& item) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (data.size() >= limit) return false;
+        data.push(item);
+        return true;
+    }
+
+    std::optional<T> tryPop() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (data.empty()) return std::nullopt;
+        std::optional<T> item(std::move(data.front()));
+        data.pop();
+        return item;
+    }
+};
+
+// Половина потоков пишет числа 1..items, половина читает; при одном потоке он пишет и
+// читает по очереди. batch > 1 - пакетные операции. Возвращает миллионы операций в секунду.
+template <typename Q>
+double measureQueue(Q& queue, unsigned threads, std::uint64_t items, std::size_t batch) {
+    auto push = [&](std::uint64_t from, std::uint64_t count) {
+        if constexpr (requires { queue.tryPushN(nullptr, 0); }) {
+            if (batch > 1) {
+                std::vector<std::uint64_t> values(batch);
+                for (std::uint64_t done = 0; done < count;) {
+                    std::size_t n = static_cast<std::size_t>(std::min<std::uint64_t>(batch, count - done));
+                    for (std::size_t i = 0; i < n; ++i) values[i] = from + done + i;
+                    for (std::size_t sent = 0; sent < n;) {
+                        std::size_t k = queue.tryPushN(values.data() + sent, n - sent);
+                        if (k == 0) std::this_thread::yield();
+                        sent += k;
+                    }
+                    done += n;
+                }
+                return;
+            }
+        }
+        for (std::uint64_t i = 0; i < count; ++i) {
+            while (!queue.tryPush(from + i)) std::this_thread::yield();
+        }
+    };
+
+    std::atomic<std::uint64_t> remaining{ items };
+    std::atomic<std::uint64_t> checksum{ 0 };
+    auto consume = [&] {
+        std::uint64_t sum = 0;
+        std::vector<std::uint64_t> values(batch);
+        while (remaining.load(std::memory_order_relaxed) > 0) {
+            std::size_t got = 0;
+            if constexpr (requires { queue.tryPopN(nullptr, 0); }) {
+                if (batch > 1) got = queue.tryPopN(values.data(), batch);
+            }
+            if (batch <= 1) {
+                if (std::optional<std::uint64_t> item = queue.tryPop()) {
+                    values[0] = *item;
+                    got = 1;
+                }
+            }
+            if (got == 0) {
+                std::this_thread::yield();
+                continue;
+            }
+            for (std::size_t i = 0; i < got; ++i) sum += values[i];
+            remaining.fetch_sub(got, std::memory_order_relaxed);
+        }
+        checksum.fetch_add(sum);
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    if (threads <= 1) {
+        std::uint64_t sum = 0;
+        for (std::uint64_t i = 1; i <= items; ++i) {
+            queue.tryPush(i);
+            sum += *queue.tryPop();
+        }
+        checksum = sum;
+    }
+    else {
+        unsigned producers = threads / 2;
+        unsigned consumers = threads - producers;
+        std::vector<std::thread> pool;
+        for (unsigned p = 0; p < producers; ++p) {
+            std::uint64_t from = items * p / producers;
+            std::uint64_t to = items * (p + 1) / producers;
+            pool.emplace_back(push, from + 1, to - from);
+        }
+        for (unsigned c = 0; c < consumers; ++c) pool.emplace_back(consume);
+        for (auto& t : pool) t.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (checksum.load() != items * (items + 1) / 2) {
+        throw std::logic_error("Queue benchmark lost or duplicated items.");
+    }
+    return 2.0 * static_cast<double>(items) / seconds / 1e6;
+}
+
+void benchmarkQueues(std::uint64_t items) {
+    const std::size_t capacity = 1024;
+    const std::size_t batch = 32;
+    std::cout << "items: " << items << ", capacity: " << capacity << ", M ops/s\n"
+        << std::setw(8) << "threads" << std::setw(14) << "mutex" << std::setw(14) << "mpmc"
+        << std::setw(14) << "mpmc x" << batch << "\n" << std::fixed << std::setprecision(2);
+    for (unsigned threads = 1; threads <= 64; threads *= 2) {
+        LockedQueue<std::uint64_t> locked(capacity);
+        ConcurrentQueue<std::uint64_t> single(capacity);
+        ConcurrentQueue<std::uint64_t> bulk(capacity);
+        std::cout << std::setw(8) << threads
+            << std::setw(14) << measureQueue(locked, threads, items, 1)
+            << std::setw(14) << measureQueue(single, threads, items, 1)
+            << std::setw(16) << measureQueue(bulk, threads, items, batch) << std::endl;
+    }
+}
+
+// Один производитель и один потребитель передают числа 1..items поэлементно и пакетами;
+// считается каждая запись и каждое чтение. Для сравнения - ConcurrentQueue на тех же потоках.
+void benchmarkSpsc(std::uint64_t items) {
+    const std::size_t capacity = 65536;
+    const std::size_t batch = 256;
+
+    auto run = [&](const char* label, auto& queue, auto&& produce, auto&& consume) {
+        std::uint64_t sum = 0;
+        auto start = std::chrono::steady_clock::now();
+        std::thread producer([&] { produce(queue); });
+        sum = consume(queue);
+        producer.join();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (sum != items * (items + 1) / 2) {
+            throw std::logic_error("Queue benchmark lost or duplicated items.");
+        }
+        std::cout << std::setw(12) << label << ": " << std::fixed << std::setprecision(1)
+            << 2.0 * static_cast<double>(items) / seconds / 1e6 << " M ops/s" << std::endl;
+    };
+
+    auto produceOne = [&](auto& queue) {
+        for (std::uint64_t i = 1; i <= items; ++i) {
+            while (!queue.tryPush(i)) std::this_thread::yield();
+        }
+    };
+    auto consumeOne = [&](auto& queue) {
+        std::uint64_t sum = 0;
+        for (std::uint64_t i = 0; i < items;) {
+            if (std::optional<std::uint64_t> item = queue.tryPop()) {
+                sum += *item;
+                ++i;
+            }
+            else {
+                std::this_thread::yield();
+            }
+        }
+        return sum;
+    };
+    auto produceBatch = [&](auto& queue) {
+        std::vector<std::uint64_t> values(batch);
+        for (std::uint64_t next = 1; next <= items;) {
+            std::size_t n = static_cast<std::size_t>(std::min<std::uint64_t>(batch, items - next + 1));
+            for (std::size_t i = 0; i < n; ++i) values[i] = next + i;
+            for (std::size_t sent = 0; sent < n;) {
+                std::size_t k = queue.pushN(values.data() + sent, n - sent);
+                if (k == 0) std::this_thread::yield();
+                sent += k;
+            }
+            next += n;
+        }
+    };
+    auto consumeBatch = [&](auto& queue) {
+        std::vector<std::uint64_t> values(batch);
+        std::uint64_t sum = 0;
+        for (std::uint64_t received = 0; received < items;) {
+            std::size_t k = queue.popN(values.data(), batch);
+            if (k == 0) std::this_thread::yield();
+            for (std::size_t i = 0; i < k; ++i) sum += values[i];
+            received += k;
+        }
+        return sum;
+    };
+
+    std::cout << "items: " << items << ", capacity: " << capacity << ", batch: " << batch << std::endl;
+    {
+        SpscQueue<std::uint64_t> queue(capacity);
+        run("spsc", queue, produceOne, consumeOne);
+    }
+    {
+        SpscQueue<std::uint64_t> queue(capacity);
+        run("spsc batch", queue, produceBatch, consumeBatch);
+    }
+    {
+        ConcurrentQueue<std::uint64_t> queue(capacity);
+        run("mpmc", queue, produceOne, consumeOne);
+    }
+}
+
 // Проверка работы исключений
-int main() {
+int main(int argc, char* argv[]) {
+    if (argc > 2 && std::string(argv[1]) == "--bench" && std::string(argv[2]) == "mpmc") {
+        benchmarkQueues(argc > 3 ? std::stoull(argv[3]) : 1000000);
+        return 0;
+    }
+    if (argc > 2 && std::string(argv[1]) == "--bench" && std::string(argv[2]) == "spsc") {
+        benchmarkSpsc(argc > 3 ? std::stoull(argv[3]) : 100000000);
+        return 0;
+    }
+
     Queue<int> intQueue;
 
     try {
@@ -67,5 +647,20 @@ int main() {
         std::cerr << "Exception caught: " << e.what() << std::endl;
     }
 
+    std::cout << "\n--- SPSC Queue Test ---" << std::endl;
+    SpscQueue<int> spscQueue(4);
+    spscQueue.push(7);
+    std::cout << "Popped: " << spscQueue.pop() << std::endl;
+    if (!spscQueue.tryPop()) {
+        std::cout << "tryPop: queue is empty." << std::endl;
+    }
+
+    try {
+        spscQueue.pop();  // Здесь исключение
+    }
+    catch (const std::runtime_error& e) {
+        std::cerr << "Exception caught: " << e.what() << std::endl;
+    }
+
     return 0;
 }
@@ -5,12 +5,92 @@
 #include <chrono>
 #include <cstdlib>
 #include <ctime>
+#include <string>
+#include <algorithm>
+#include <cstdint>
+#include <atomic>
+#include <deque>
+#include <optional>
+#include <sstream>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <iomanip>
 
-std::mutex monstersMutex;
 std::mutex battleMutex;
 
-bool battleInProgress = false;
-bool heroAlive = true;
+std::atomic<bool> battleInProgress{ false };
+
+// ==== Случайные числа ====
+
+// xoshiro256** со своим состоянием у каждого потока: без общего состояния libc rand()
+// и без смещения rand() % n. jump() сдвигает поток на 2^128 чисел.
+class Xoshiro256 {
+private:
+    std::uint64_t s[4];
+
+    static std::uint64_t rotl(std::uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+public:
+    explicit Xoshiro256(std::uint64_t seed) {
+        for (auto& word : s) {
+            std::uint64_t z = (seed += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            word = z ^ (z >> 31);
+        }
+    }
+
+    std::uint64_t next() {
+        std::uint64_t result = rotl(s[1] * 5, 7) * 9;
+        std::uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+
+    void jump() {
+        static constexpr std::uint64_t JUMP[] = {
+            0x180EC6D33CFD0ABAull, 0xD5A61266F0C9392Cull, 0xA9582618E03FC9AAull, 0x39ABDC4529B1661Cull
+        };
+        std::uint64_t t[4] = {};
+        for (std::uint64_t word : JUMP) {
+            for (int b = 0; b < 64; ++b) {
+                if (word & (1ull << b)) {
+                    for (int i = 0; i < 4; ++i) t[i] ^= s[i];
+                }
+                next();
+            }
+        }
+        for (int i = 0; i < 4; ++i) s[i] = t[i];
+    }
+
+    // Равномерно на [0, n) без смещения (метод Лемира)
+    unsigned below(unsigned n) {
+        std::uint64_t m = (next() >> 32) * n;
+        if (static_cast<std::uint32_t>(m) < n) {
+            std::uint32_t threshold = static_cast<std::uint32_t>(-n) % n;
+            while (static_cast<std::uint32_t>(m) < threshold) m = (next() >> 32) * n;
+        }
+        return static_cast<unsigned>(m >> 32);
+    }
+};
+
+// Генератор текущего потока: k-й поток получает общий поток, сдвинутый на k прыжков
+Xoshiro256& threadRng() {
+    static const std::uint64_t seed = static_cast<std::uint64_t>(std::time(nullptr));
+    static std::atomic<unsigned> threads{ 0 };
+    thread_local Xoshiro256 rng = [] {
+        Xoshiro256 engine(seed);
+        for (unsigned i = threads.fetch_add(1); i > 0; --i) engine.jump();
+        return engine;
+    }();
+    return rng;
+}
 
 // ==== Классы ====
 
@@ -54,93 +134,717 @@ public:
     }
 };
 
-// ==== Глобальные объекты ====
-std::vector<Monster> monsters;
-Character hero("Hero", 100, 20, 10);
+// ==== Симуляция боя ====
 
-// ==== Генерация монстров ====
-void generateMonsters() {
-    std::vector<std::string> types = { "Goblin", "Orc", "Troll", "Skeleton" };
-    std::srand(static_cast<unsigned>(std::time(nullptr)));
+// Темп боя: в реальном времени или без пауз, для прогонов баланса
+enum class Pacing {
+    RealTime,
+    AsFastAsPossible
+};
+
+struct BattleOutcome {
+    bool heroWon;
+    int rounds;
+    std::chrono::milliseconds duration;  // по виртуальным часам
+};
 
-    while (heroAlive) {
-        std::this_thread::sleep_for(std::chrono::seconds(3));
-        std::lock_guard<std::mutex> lock(monstersMutex);
-        std::string type = types[rand() % types.size()];
-        monsters.emplace_back(type, 50 + rand() % 51, 10 + rand() % 11, 5 + rand() % 6);
-        std::cout << "[+] New monster generated!\n";
+// Раунды боя по виртуальным часам: раунд k происходит в момент k * roundInterval.
+// В режиме RealTime раунд ждёт, пока до этого момента дойдут настоящие часы.
+BattleOutcome runBattle(Character& hero, Monster& monster, Pacing pacing, bool verbose,
+    std::chrono::milliseconds roundInterval = std::chrono::milliseconds(500)) {
+    auto wallStart = std::chrono::steady_clock::now();
+    std::chrono::milliseconds now(0);
+    int rounds = 0;
+
+    while (monster.isAlive() && hero.isAlive()) {
+        now += roundInterval;
+        ++rounds;
+        if (pacing == Pacing::RealTime) {
+            std::this_thread::sleep_until(wallStart + now);
+        }
+
+        // Hero attacks
+        int heroDamage = std::max(0, hero.attack - monster.defense);
+        monster.health -= heroDamage;
+        if (verbose) std::cout << "Hero hits " << monster.type << " for " << heroDamage << " damage!\n";
+
+        if (!monster.isAlive()) {
+            if (verbose) std::cout << monster.type << " is defeated!\n";
+            break;
+        }
+
+        // Monster attacks
+        int monsterDamage = std::max(0, monster.attack - hero.defense);
+        hero.health -= monsterDamage;
+        if (verbose) std::cout << monster.type << " hits Hero for " << monsterDamage << " damage!\n";
+
+        if (!hero.isAlive()) {
+            if (verbose) std::cout << "💀 Hero has been defeated!\n";
+            break;
+        }
     }
+    return { hero.isAlive(), rounds, now };
 }
 
-// ==== Бой между героем и монстром ====
-void fight() {
-    while (heroAlive) {
-        std::this_thread::sleep_for(std::chrono::seconds(1));
-        std::lock_guard<std::mutex> lock(monstersMutex);
+// ==== Синхронизация ====
+
+// Время удержания мьютекса: число захватов, суммарное и наибольшее время
+struct LockStats {
+    std::atomic<std::uint64_t> acquisitions{ 0 };
+    std::atomic<std::uint64_t> totalNanos{ 0 };
+    std::atomic<std::uint64_t> maxNanos{ 0 };
+
+    void record(std::uint64_t nanos) {
+        acquisitions.fetch_add(1, std::memory_order_relaxed);
+        totalNanos.fetch_add(nanos, std::memory_order_relaxed);
+        std::uint64_t seen = maxNanos.load(std::memory_order_relaxed);
+        while (nanos > seen && !maxNanos.compare_exchange_weak(seen, nanos, std::memory_order_relaxed)) {
+        }
+    }
 
-        if (!monsters.empty() && !battleInProgress) {
-            battleInProgress = true;
-            Monster& monster = monsters.front();
+    void print(std::ostream& out, const char* label) const {
+        std::uint64_t n = acquisitions.load(std::memory_order_relaxed);
+        out << label << ": " << n << " acquisitions, avg "
+            << (n ? totalNanos.load(std::memory_order_relaxed) / n : 0) << " ns, max "
+            << maxNanos.load(std::memory_order_relaxed) << " ns\n";
+    }
+};
 
-            std::cout << "\n⚔️ Battle started between Hero and " << monster.type << "!\n";
+// Замер удержания: создаётся сразу после захвата мьютекса, разрушается перед освобождением
+class HoldTimer {
+private:
+    LockStats& stats;
+    std::chrono::steady_clock::time_point start;
 
-            while (monster.isAlive() && hero.isAlive()) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(500));
+public:
+    explicit HoldTimer(LockStats& s) : stats(s), start(std::chrono::steady_clock::now()) {}
+    HoldTimer(const HoldTimer&) = delete;
+    HoldTimer& operator=(const HoldTimer&) = delete;
+
+    ~HoldTimer() {
+        stats.record(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count()));
+    }
+};
 
-                // Hero attacks
-                int heroDamage = std::max(0, hero.attack - monster.defense);
-                monster.health -= heroDamage;
-                std::cout << "Hero hits " << monster.type << " for " << heroDamage << " damage!\n";
+// Очередь новых монстров между генератором и боем. pop() ждёт на условной переменной,
+// а не опрашивает очередь; бой идёт уже с вынутым монстром, вне блокировки.
+class SpawnQueue {
+private:
+    mutable std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<Monster> items;
+    bool closed = false;
+    mutable LockStats stats;
 
-                if (!monster.isAlive()) {
-                    std::cout << monster.type << " is defeated!\n";
-                    break;
+public:
+    void push(Monster monster) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            HoldTimer timer(stats);
+            items.push_back(std::move(monster));
+        }
+        ready.notify_one();
+    }
+
+    // Следующий монстр; пусто, если очередь закрыта
+    std::optional<Monster> pop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        ready.wait(lock, [this] { return closed || !items.empty(); });
+        HoldTimer timer(stats);  // ожидание не в счёт: мьютекс в это время свободен
+        if (closed) return std::nullopt;
+        Monster monster = std::move(items.front());
+        items.pop_front();
+        return monster;
+    }
+
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            HoldTimer timer(stats);
+            closed = true;
+        }
+        ready.notify_all();
+    }
+
+    // Копия очереди для вывода: под блокировкой только копирование
+    std::vector<Monster> snapshot() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        HoldTimer timer(stats);
+        return std::vector<Monster>(items.begin(), items.end());
+    }
+
+    const LockStats& lockStats() const { return stats; }
+};
+
+// Пул потоков с кражей работы: у каждого потока своя очередь задач. Поток берёт задачи
+// с конца своей очереди, а когда она пуста - самую старую задачу из чужой.
+// Задачи могут ставить новые задачи; те попадают в очередь текущего потока.
+class WorkStealingPool {
+public:
+    using Task = std::function<void()>;
+
+private:
+    struct alignas(64) Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+    std::atomic<std::uint64_t> queued{ 0 };   // лежат в очередях
+    std::atomic<std::uint64_t> pending{ 0 };  // поставлены и ещё не выполнены
+    std::atomic<std::uint64_t> steals{ 0 };
+    std::atomic<unsigned> sleepers{ 0 };
+    std::atomic<unsigned> nextWorker{ 0 };
+    std::mutex sleepMutex;
+    std::condition_variable wake;  // появилась работа или пул останавливается
+    std::condition_variable idle;  // pending дошёл до нуля
+    bool stopping = false;
+
+    inline static thread_local WorkStealingPool* currentPool = nullptr;
+    inline static thread_local unsigned currentIndex = 0;
+
+    bool take(unsigned index, Task& task) {
+        Worker& w = *workers[index];
+        std::lock_guard<std::mutex> lock(w.mutex);
+        if (w.tasks.empty()) return false;
+        task = std::move(w.tasks.back());
+        w.tasks.pop_back();
+        return true;
+    }
+
+    bool steal(unsigned index, Task& task) {
+        for (size_t k = 1; k < workers.size(); ++k) {
+            Worker& w = *workers[(index + k) % workers.size()];
+            std::lock_guard<std::mutex> lock(w.mutex);
+            if (!w.tasks.empty()) {
+                task = std::move(w.tasks.front());
+                w.tasks.pop_front();
+                steals.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void run(unsigned index) {
+        currentPool = this;
+        currentIndex = index;
+        for (;;) {
+            Task task;
+            if (take(index, task) || steal(index, task)) {
+                queued.fetch_sub(1);
+                task();
+                if (pending.fetch_sub(1) == 1) {
+                    std::lock_guard<std::mutex> lock(sleepMutex);
+                    idle.notify_all();
                 }
+                continue;
+            }
+
+            // Засыпает, только убедившись под sleepMutex, что очереди пусты; submit видит
+            // sleepers > 0 и будит, так что уведомление не теряется
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            sleepers.fetch_add(1);
+            wake.wait(lock, [this] { return stopping || queued.load() > 0; });
+            sleepers.fetch_sub(1);
+            if (stopping && queued.load() == 0) return;
+        }
+    }
+
+public:
+    explicit WorkStealingPool(unsigned count) {
+        count = std::max(1u, count);
+        for (unsigned i = 0; i < count; ++i) workers.push_back(std::make_unique<Worker>());
+        for (unsigned i = 0; i < count; ++i) threads.emplace_back(&WorkStealingPool::run, this, i);
+    }
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    ~WorkStealingPool() {
+        waitIdle();
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& t : threads) t.join();
+    }
+
+    void submit(Task task) {
+        unsigned index = currentPool == this ? currentIndex
+            : nextWorker.fetch_add(1, std::memory_order_relaxed) % workers.size();
+        pending.fetch_add(1);
+        {
+            std::lock_guard<std::mutex> lock(workers[index]->mutex);
+            workers[index]->tasks.push_back(std::move(task));
+        }
+        queued.fetch_add(1);
+        if (sleepers.load() > 0) {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            wake.notify_one();
+        }
+    }
+
+    // Ждёт, пока не будут выполнены все задачи, включая поставленные из задач
+    void waitIdle() {
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        idle.wait(lock, [this] { return pending.load() == 0; });
+    }
+
+    size_t size() const { return workers.size(); }
+    std::uint64_t stealCount() const { return steals.load(std::memory_order_relaxed); }
+
+    // Номер потока пула, выполняющего текущую задачу
+    static unsigned currentWorker() { return currentIndex; }
+};
+
+// Колесо таймеров: слот i хранит таймеры, чей тик (время / tick) даёт остаток i по числу
+// слотов. Добавление и срабатывание - O(1) на таймер; таймер дальше одного оборота
+// колеса лежит в том же слоте, пока не дойдёт его оборот.
+class TimerWheel {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Callback = std::function<void()>;
+
+private:
+    struct Timer {
+        std::uint64_t tick;
+        Callback callback;
+    };
+
+    Clock::time_point origin;
+    Clock::duration tick;
+    std::vector<std::vector<Timer>> slots;
+    std::uint64_t current = 0;  // последний обработанный тик
+    size_t count = 0;
+
+    std::uint64_t tickAt(Clock::time_point t) const {
+        return t <= origin ? 0 : static_cast<std::uint64_t>((t - origin) / tick);
+    }
+
+public:
+    TimerWheel(Clock::duration tickLength, size_t slotCount, Clock::time_point start = Clock::now())
+        : origin(start), tick(tickLength), slots(slotCount) {
+    }
 
-                // Monster attacks
-                int monsterDamage = std::max(0, monster.attack - hero.defense);
-                hero.health -= monsterDamage;
-                std::cout << monster.type << " hits Hero for " << monsterDamage << " damage!\n";
+    // Таймер срабатывает не раньше when, округлённого вверх до тика
+    void schedule(Clock::time_point when, Callback callback) {
+        std::uint64_t t = tickAt(when);
+        if (origin + t * tick < when) ++t;
+        t = std::max(t, current + 1);
+        slots[t % slots.size()].push_back({ t, std::move(callback) });
+        ++count;
+    }
 
-                if (!hero.isAlive()) {
-                    std::cout << "💀 Hero has been defeated!\n";
-                    heroAlive = false;
-                    break;
+    // Переносит в due всё, что наступило к now
+    void advance(Clock::time_point now, std::vector<Callback>& due) {
+        std::uint64_t target = tickAt(now);
+        if (target <= current) return;
+        std::uint64_t steps = std::min<std::uint64_t>(target - current, slots.size());
+        for (std::uint64_t k = 1; k <= steps; ++k) {
+            auto& slot = slots[(current + k) % slots.size()];
+            for (size_t i = 0; i < slot.size();) {
+                if (slot[i].tick <= target) {
+                    due.push_back(std::move(slot[i].callback));
+                    slot[i] = std::move(slot.back());
+                    slot.pop_back();
+                    --count;
+                }
+                else {
+                    ++i;
                 }
             }
+        }
+        current = target;
+    }
 
-            if (!monsters.empty()) monsters.erase(monsters.begin());
-            battleInProgress = false;
+    // Начало ближайшего непустого слота; пусто, если таймеров нет
+    std::optional<Clock::time_point> nextDeadline() const {
+        if (count == 0) return std::nullopt;
+        for (std::uint64_t k = 1; k <= slots.size(); ++k) {
+            if (!slots[(current + k) % slots.size()].empty()) return origin + (current + k) * tick;
         }
+        return std::nullopt;
     }
-}
+};
 
-// ==== Главная функция ====
-int main() {
-    std::thread monsterThread(generateMonsters);
-    std::thread battleThread(fight);
+// Цикл событий: поток спит на условной переменной до ближайшего таймера или до post().
+// Без событий и таймеров поток не просыпается вовсе.
+class EventLoop {
+public:
+    using Clock = TimerWheel::Clock;
+    using Callback = TimerWheel::Callback;
+
+private:
+    std::mutex mutex;
+    std::condition_variable changed;
+    TimerWheel wheel;
+    std::deque<Callback> posted;
+    bool stopped = false;
+    std::thread::id loopThread;
+    std::atomic<std::uint64_t> wakeups{ 0 };
+
+    void repeat(Clock::time_point due, std::chrono::milliseconds interval, std::shared_ptr<Callback> callback) {
+        at(due, [this, due, interval, callback] {
+            (*callback)();
+            repeat(due + interval, interval, callback);
+        });
+    }
+
+public:
+    explicit EventLoop(std::chrono::milliseconds tick = std::chrono::milliseconds(10), size_t slots = 1024)
+        : wheel(tick, slots) {
+    }
 
-    while (heroAlive) {
-        std::this_thread::sleep_for(std::chrono::seconds(2));
+    void post(Callback callback) {
+        bool outside;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            posted.push_back(std::move(callback));
+            outside = std::this_thread::get_id() != loopThread;
+        }
+        if (outside) changed.notify_one();
+    }
 
+    // Будить нужно только из чужого потока: свой поток пересчитает срок перед сном
+    void at(Clock::time_point when, Callback callback) {
+        bool outside;
         {
-            std::lock_guard<std::mutex> lock(monstersMutex);
-            std::cout << "\n[INFO] Current Monsters:\n";
-            for (const auto& monster : monsters) {
-                monster.displayInfo();
+            std::lock_guard<std::mutex> lock(mutex);
+            wheel.schedule(when, std::move(callback));
+            outside = std::this_thread::get_id() != loopThread;
+        }
+        if (outside) changed.notify_one();
+    }
+
+    // Повтор каждые interval от первого срока, без накопления сдвига
+    void every(std::chrono::milliseconds interval, Callback callback) {
+        repeat(Clock::now() + interval, interval, std::make_shared<Callback>(std::move(callback)));
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopped = true;
+        }
+        changed.notify_one();
+    }
+
+    // Выполняет события до stop(); обработчики вызываются без блокировки
+    void run() {
+        std::vector<Callback> due;
+        std::unique_lock<std::mutex> lock(mutex);
+        loopThread = std::this_thread::get_id();
+        while (!stopped) {
+            wheel.advance(Clock::now(), due);
+            while (!posted.empty()) {
+                due.push_back(std::move(posted.front()));
+                posted.pop_front();
+            }
+            if (!due.empty()) {
+                lock.unlock();
+                for (auto& callback : due) callback();
+                due.clear();
+                lock.lock();
+                continue;
+            }
+
+            auto ready = [this] { return stopped || !posted.empty(); };
+            if (std::optional<Clock::time_point> deadline = wheel.nextDeadline()) {
+                changed.wait_until(lock, *deadline, ready);
             }
+            else {
+                changed.wait(lock, ready);
+            }
+            wakeups.fetch_add(1, std::memory_order_relaxed);
         }
+    }
+
+    std::uint64_t wakeupCount() const { return wakeups.load(std::memory_order_relaxed); }
+};
+
+// ==== Глобальные объекты ====
+SpawnQueue spawnQueue;
+Character hero("Hero", 100, 20, 10);
+LockStats heroLockStats;  // battleMutex, защищающий hero
+
+EventLoop gameLoop;
+std::atomic<std::int64_t> gameOverAt{ 0 };  // steady_clock, нс; момент смерти героя
+
+const auto gameStart = std::chrono::steady_clock::now();
+std::atomic<std::uint64_t> monstersProcessed{ 0 };
 
+// Смерть героя: очередь закрывается, цикл событий останавливается сразу, без ожидания таймеров
+void endGame() {
+    gameOverAt = std::chrono::steady_clock::now().time_since_epoch().count();
+    spawnQueue.close();
+    gameLoop.stop();
+}
+
+void printMetrics(std::ostream& out) {
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - gameStart).count();
+    std::uint64_t processed = monstersProcessed.load(std::memory_order_relaxed);
+    out << "[INFO] Monsters processed: " << processed << " (" << processed / seconds << "/s)\n";
+    spawnQueue.lockStats().print(out, "[INFO] Spawn queue lock");
+    heroLockStats.print(out, "[INFO] Hero lock");
+    out << "[INFO] Event loop wakeups: " << gameLoop.wakeupCount() << "\n";
+}
+
+// ==== Генерация монстров ====
+// Вызывается таймером цикла событий раз в 3 секунды
+void generateMonster() {
+    static const std::vector<std::string> types = { "Goblin", "Orc", "Troll", "Skeleton" };
+    Xoshiro256& rng = threadRng();
+
+    std::string type = types[rng.below(static_cast<unsigned>(types.size()))];
+    spawnQueue.push(Monster(type, 50 + rng.below(51), 10 + rng.below(11), 5 + rng.below(6)));
+    std::cout << "[+] New monster generated!\n";
+}
+
+// Вызывается таймером цикла событий раз в 2 секунды
+void printStatus() {
+    std::vector<Monster> waiting = spawnQueue.snapshot();
+    Character status = [] {
+        std::lock_guard<std::mutex> lock(battleMutex);
+        HoldTimer timer(heroLockStats);
+        return hero;
+    }();
+
+    std::cout << "\n[INFO] Current Monsters:\n";
+    for (const auto& monster : waiting) {
+        monster.displayInfo();
+    }
+    std::cout << "[INFO] Hero status" << (battleInProgress ? " (in battle)" : "") << ":\n";
+    status.displayInfo();
+    std::ostringstream metrics;
+    printMetrics(metrics);
+    std::cout << metrics.str();
+}
+
+// ==== Бой между героем и монстром ====
+// Бой идёт с копией героя без блокировок; под battleMutex только копирование туда и обратно
+void fight() {
+    while (std::optional<Monster> next = spawnQueue.pop()) {
+        Monster monster = std::move(*next);
+        battleInProgress = true;
+        std::cout << "\n⚔️ Battle started between Hero and " << monster.type << "!\n";
+
+        Character fighter = [] {
+            std::lock_guard<std::mutex> lock(battleMutex);
+            HoldTimer timer(heroLockStats);
+            return hero;
+        }();
+        BattleOutcome outcome = runBattle(fighter, monster, Pacing::RealTime, true);
         {
             std::lock_guard<std::mutex> lock(battleMutex);
-            std::cout << "[INFO] Hero status:\n";
-            hero.displayInfo();
+            HoldTimer timer(heroLockStats);
+            hero = fighter;
         }
+
+        monstersProcessed.fetch_add(1, std::memory_order_relaxed);
+        battleInProgress = false;
+        if (!outcome.heroWon) {
+            endGame();
+            break;
+        }
+        gameLoop.post([type = monster.type, outcome] {
+            std::cout << "[INFO] Battle with " << type << " won in " << outcome.rounds << " rounds\n";
+        });
+    }
+}
+
+// ==== Прогон боёв без пауз ====
+// Свежий герой против монстров со всеми сочетаниями характеристик из generateMonster
+void benchmarkBattles(int battles) {
+    long long wins = 0;
+    long long rounds = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < battles; ++i) {
+        Character fighter("Hero", 100, 20, 10);
+        Monster monster("Goblin", 50 + i % 51, 10 + (i / 51) % 11, 5 + (i / 561) % 6);
+        BattleOutcome outcome = runBattle(fighter, monster, Pacing::AsFastAsPossible, false);
+        wins += outcome.heroWon;
+        rounds += outcome.rounds;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "battles: " << battles << ", rounds: " << rounds << "\n"
+        << "time: " << seconds * 1000 << " ms, " << battles / seconds / 1e6 << " M battles/s\n"
+        << "hero win rate: " << 100.0 * wins / battles << "%\n";
+}
+
+// ==== Арена ====
+// N героев и M генераторов монстров. Генератор - цепочка задач пула: каждая создаёт пачку
+// монстров, ставит задачу боёв с ней и следующую задачу генератора. Бои идут без пауз,
+// каждый со свежей копией героя; итоги копятся отдельно у каждого потока и
+// складываются в конце, так что общей блокировки нет.
+
+struct ArenaOptions {
+    unsigned heroes = 4;
+    unsigned spawners = 4;
+    std::uint64_t monstersPerSpawner = 1000000;
+    unsigned batch = 1024;
+    std::uint64_t seed = 1;
+};
+
+// Выровнено по кэш-линии: счётчики разных потоков не делят линию
+struct alignas(64) HeroTally {
+    std::uint64_t battles = 0;
+    std::uint64_t wins = 0;
+    std::uint64_t rounds = 0;
+};
+
+struct ArenaShard {
+    std::vector<HeroTally> heroes;
+};
+
+struct ArenaResult {
+    std::vector<HeroTally> heroes;
+    double seconds;
+    std::uint64_t steals;
+};
+
+std::vector<Character> makeArenaHeroes(unsigned count) {
+    std::vector<Character> heroes;
+    for (unsigned i = 0; i < count; ++i) {
+        heroes.emplace_back("Hero " + std::to_string(i + 1), 100, 18 + static_cast<int>(i % 5), 8 + static_cast<int>(i / 5 % 5));
     }
+    return heroes;
+}
+
+ArenaResult runArena(const ArenaOptions& options, unsigned threads) {
+    const std::vector<Character> heroes = makeArenaHeroes(options.heroes);
+    static const std::string types[] = { "Goblin", "Orc", "Troll", "Skeleton" };
+    std::vector<ArenaShard> shards(std::max(1u, threads));
+    for (auto& shard : shards) shard.heroes.resize(heroes.size());
+
+    auto start = std::chrono::steady_clock::now();
+    std::uint64_t steals;
+    {
+        WorkStealingPool pool(threads);
+
+        auto fightBatch = [&heroes, &shards](std::vector<Monster> batch, std::uint64_t first) {
+            std::vector<HeroTally>& tally = shards[WorkStealingPool::currentWorker()].heroes;
+            for (size_t i = 0; i < batch.size(); ++i) {
+                size_t h = (first + i) % heroes.size();
+                Character fighter = heroes[h];
+                BattleOutcome outcome = runBattle(fighter, batch[i], Pacing::AsFastAsPossible, false);
+                ++tally[h].battles;
+                tally[h].wins += outcome.heroWon;
+                tally[h].rounds += static_cast<std::uint64_t>(outcome.rounds);
+            }
+        };
 
-    monsterThread.join();
+        // Генератор s выдаёт монстров с номера first; rng переходит к следующей задаче цепочки
+        std::function<void(unsigned, std::uint64_t, Xoshiro256)> spawn =
+            [&](unsigned s, std::uint64_t first, Xoshiro256 rng) {
+            std::uint64_t count = std::min<std::uint64_t>(options.batch, options.monstersPerSpawner - first);
+            std::vector<Monster> batch;
+            batch.reserve(count);
+            for (std::uint64_t i = 0; i < count; ++i) {
+                const std::string& type = types[rng.below(4)];
+                int h = 50 + static_cast<int>(rng.below(51));
+                int a = 10 + static_cast<int>(rng.below(11));
+                int d = 5 + static_cast<int>(rng.below(6));
+                batch.emplace_back(type, h, a, d);
+            }
+            if (first + count < options.monstersPerSpawner) {
+                pool.submit([&spawn, s, next = first + count, rng] { spawn(s, next, rng); });
+            }
+            std::uint64_t offset = s + first;
+            pool.submit([&fightBatch, batch = std::move(batch), offset]() mutable { fightBatch(std::move(batch), offset); });
+        };
+
+        Xoshiro256 rng(options.seed);
+        for (unsigned s = 0; s < options.spawners; ++s) {
+            if (options.monstersPerSpawner > 0) pool.submit([&spawn, s, rng] { spawn(s, 0, rng); });
+            rng.jump();
+        }
+        pool.waitIdle();
+        steals = pool.stealCount();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    ArenaResult result{ std::vector<HeroTally>(heroes.size()), seconds, steals };
+    for (const auto& shard : shards) {
+        for (size_t h = 0; h < heroes.size(); ++h) {
+            result.heroes[h].battles += shard.heroes[h].battles;
+            result.heroes[h].wins += shard.heroes[h].wins;
+            result.heroes[h].rounds += shard.heroes[h].rounds;
+        }
+    }
+    return result;
+}
+
+// Без явного числа потоков прогоняет 1, 2, 4, ... потоков до числа ядер и печатает ускорение
+void runArenaTool(const ArenaOptions& options, unsigned threads) {
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<unsigned> counts;
+    if (threads > 0) {
+        counts.push_back(threads);
+    }
+    else {
+        for (unsigned t = 1; t < cores; t *= 2) counts.push_back(t);
+        counts.push_back(cores);
+    }
+
+    std::uint64_t battles = static_cast<std::uint64_t>(options.spawners) * options.monstersPerSpawner;
+    std::cout << "arena: " << options.heroes << " heroes, " << options.spawners << " spawners x "
+        << options.monstersPerSpawner << " monsters, " << cores << " cores\n";
+
+    ArenaResult last{};
+    double baseline = 0;
+    for (unsigned t : counts) {
+        last = runArena(options, t);
+        if (baseline == 0) baseline = last.seconds;
+        std::cout << "threads " << t << ": " << std::fixed << std::setprecision(1) << last.seconds * 1000 << " ms, "
+            << std::setprecision(2) << battles / last.seconds / 1e6 << " M battles/s, speedup "
+            << baseline / last.seconds << ", steals " << last.steals << "\n";
+    }
+
+    std::vector<Character> heroes = makeArenaHeroes(options.heroes);
+    for (size_t h = 0; h < heroes.size(); ++h) {
+        const HeroTally& tally = last.heroes[h];
+        std::cout << heroes[h].name << " (ATK " << heroes[h].attack << ", DEF " << heroes[h].defense << "): "
+            << tally.battles << " battles, win rate " << std::setprecision(2)
+            << (tally.battles ? 100.0 * tally.wins / tally.battles : 0) << "%, avg rounds "
+            << (tally.battles ? static_cast<double>(tally.rounds) / tally.battles : 0) << "\n";
+    }
+}
+
+// ==== Главная функция ====
+int main(int argc, char* argv[]) {
+    if (argc > 2 && std::string(argv[1]) == "--bench" && std::string(argv[2]) == "sim") {
+        benchmarkBattles(argc > 3 ? std::stoi(argv[3]) : 3000000);
+        return 0;
+    }
+    if (argc > 1 && std::string(argv[1]) == "--arena") {
+        ArenaOptions options;
+        if (argc > 2) options.heroes = static_cast<unsigned>(std::stoul(argv[2]));
+        if (argc > 3) options.spawners = static_cast<unsigned>(std::stoul(argv[3]));
+        if (argc > 4) options.monstersPerSpawner = std::stoull(argv[4]);
+        if (options.heroes == 0) {
+            std::cerr << "arena needs at least one hero\n";
+            return 1;
+        }
+        runArenaTool(options, argc > 5 ? static_cast<unsigned>(std::stoul(argv[5])) : 0);
+        return 0;
+    }
+
+    // Генератор и вывод состояния - таймеры цикла событий в главном потоке;
+    // бой идёт в своём потоке и просыпается, только когда в очереди есть монстр
+    std::thread battleThread(fight);
+    gameLoop.every(std::chrono::seconds(3), generateMonster);
+    gameLoop.every(std::chrono::seconds(2), printStatus);
+    gameLoop.run();
     battleThread.join();
 
+    auto shutdown = std::chrono::steady_clock::now().time_since_epoch() - std::chrono::steady_clock::duration(gameOverAt.load());
     std::cout << "\n=== Game Over ===\n";
+    printMetrics(std::cout);
+    std::cout << "[INFO] Shutdown took " << std::chrono::duration_cast<std::chrono::microseconds>(shutdown).count() << " us\n";
     return 0;
 }
\ No newline at end of file
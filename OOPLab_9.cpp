@@ -8,44 +8,1275 @@
 #include <stdexcept>
 #include <thread>
 #include <sstream>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+#include <ctime>
+#include <charconv>
+#include <mutex>
+#include <unordered_map>
+#include <filesystem>
+#include <condition_variable>
+#include <deque>
+
+// Локальное время: localtime_s есть только в MSVC, в POSIX потокобезопасный вариант - localtime_r
+inline std::tm localTime(std::time_t time) {
+    std::tm tm{};
+#ifdef _WIN32
+    localtime_s(&tm, &time);
+#else
+    localtime_r(&time, &tm);
+#endif
+    return tm;
+}
+
+// Отметки времени "[YYYY-MM-DD HH:MM:SS.fff]" для лога.
+// Часть до секунд пересчитывается через localTime и strftime только при смене секунды
+// (кэш у каждого потока свой), дробная часть дописывается целочисленной арифметикой.
+class Timestamp {
+public:
+    enum class Clock {
+        System,  // system_clock::now()
+        Coarse   // CLOCK_REALTIME_COARSE там, где он есть: дешевле, но с шагом в тик таймера
+    };
+
+    static constexpr size_t MAX_LENGTH = 32;
+
+    // Пишет отметку с digits (0..9) знаками после секунд в buf, возвращает длину
+    static size_t format(char* buf, int digits, Clock clock = Clock::System) {
+        std::int64_t seconds;
+        std::uint32_t nanos;
+        now(clock, seconds, nanos);
+        return format(buf, digits, seconds, nanos);
+    }
+
+    // То же для заданного момента (секунды Unix-времени и наносекунды)
+    static size_t format(char* buf, int digits, std::int64_t seconds, std::uint32_t nanos) {
+        thread_local std::int64_t cachedSecond = INT64_MIN;
+        thread_local char cachedText[PREFIX_LENGTH + 1];
+        if (seconds != cachedSecond) {
+            std::tm tm = localTime(static_cast<std::time_t>(seconds));
+            std::strftime(cachedText, sizeof(cachedText), "[%Y-%m-%d %H:%M:%S", &tm);
+            cachedSecond = seconds;
+        }
+
+        std::memcpy(buf, cachedText, PREFIX_LENGTH);
+        size_t length = PREFIX_LENGTH;
+        digits = std::clamp(digits, 0, 9);
+        if (digits > 0) {
+            buf[length++] = '.';
+            std::uint32_t fraction = nanos / POW10[9 - digits];
+            for (int i = digits - 1; i >= 0; --i) {
+                buf[length + i] = static_cast<char>('0' + fraction % 10);
+                fraction /= 10;
+            }
+            length += digits;
+        }
+        buf[length++] = ']';
+        return length;
+    }
+
+    static std::string format(int digits, Clock clock = Clock::System) {
+        char buf[MAX_LENGTH];
+        return std::string(buf, format(buf, digits, clock));
+    }
+
+    static void now(Clock clock, std::int64_t& seconds, std::uint32_t& nanos) {
+#ifdef CLOCK_REALTIME_COARSE
+        if (clock == Clock::Coarse) {
+            timespec ts;
+            clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+            seconds = ts.tv_sec;
+            nanos = static_cast<std::uint32_t>(ts.tv_nsec);
+            return;
+        }
+#else
+        (void)clock;
+#endif
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        seconds = ns / 1000000000;
+        std::int64_t rest = ns % 1000000000;
+        if (rest < 0) {
+            rest += 1000000000;
+            --seconds;
+        }
+        nanos = static_cast<std::uint32_t>(rest);
+    }
 
-// Шаблонный класс Logger
-template <typename T = std::string>
-class Logger {
 private:
-    std::ofstream logFile;
+    static constexpr size_t PREFIX_LENGTH = 20;  // "[YYYY-MM-DD HH:MM:SS"
+    static constexpr std::uint32_t POW10[10] = {
+        1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+    };
+};
 
-    std::string getCurrentTime() {
-        auto now = std::chrono::system_clock::now();
-        auto in_time_t = std::chrono::system_clock::to_time_t(now);
-        char buf[80];
-        std::tm tm;
-        localtime_s(&tm, &in_time_t);
-        strftime(buf, sizeof(buf), "[%Y-%m-%d %H:%M:%S]", &tm);
-        return std::string(buf);
+// Что делать, если очередь асинхронного логгера заполнена
+enum class OverflowPolicy {
+    Block,  // ждать, пока фоновый поток освободит место
+    Drop,   // отбросить запись
+    Sample  // сохранить каждую sampleRate-ю запись из переполнения, остальные отбросить
+};
+
+// Параметры асинхронного режима Logger
+struct AsyncOptions {
+    size_t capacity = 8192;         // число записей в очереди, степень двойки
+    OverflowPolicy overflow = OverflowPolicy::Block;
+    size_t sampleRate = 16;
+    size_t maxBatch = 1 << 16;      // максимальный размер одной записи в файл, байт
+};
+
+// Ограниченная MPSC-очередь строк на кольцевом буфере.
+// Каждая ячейка хранит номер последовательности: производители занимают ячейку
+// через CAS по tail, единственный потребитель читает без CAS. Строки в ячейках
+// переиспользуются, поэтому в установившемся режиме push не выделяет память.
+class MpscRingBuffer {
+private:
+    struct alignas(64) Cell {
+        std::atomic<size_t> sequence{ 0 };
+        std::string text;
+    };
+
+    std::unique_ptr<Cell[]> cells;
+    size_t mask;
+    alignas(64) std::atomic<size_t> tail{ 0 };
+    alignas(64) size_t head = 0;
+
+public:
+    explicit MpscRingBuffer(size_t capacity) {
+        if (capacity < 2 || (capacity & (capacity - 1)) != 0) {
+            throw std::invalid_argument("Queue capacity must be a power of two");
+        }
+        cells = std::make_unique<Cell[]>(capacity);
+        for (size_t i = 0; i < capacity; ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        mask = capacity - 1;
+    }
+
+    // Заполняет свободную ячейку через fill(std::string&); false, если очередь полна.
+    // Если fill бросает исключение, ячейка всё равно публикуется пустой (потребитель
+    // пропускает пустые записи), иначе на ней навсегда встал бы фоновый поток.
+    template <typename Fill>
+    bool tryPush(Fill&& fill) {
+        size_t pos = tail.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells[pos & mask];
+            size_t seq = cell.sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+            if (diff == 0) {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.text.clear();
+                    try {
+                        fill(cell.text);
+                    }
+                    catch (...) {
+                        cell.text.clear();
+                        cell.sequence.store(pos + 1, std::memory_order_release);
+                        throw;
+                    }
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0) {
+                return false;
+            }
+            else {
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Только для потока-потребителя: передаёт очередную запись в consume(const std::string&)
+    template <typename Consume>
+    bool tryPop(Consume&& consume) {
+        Cell& cell = cells[head & mask];
+        if (cell.sequence.load(std::memory_order_acquire) != head + 1) return false;
+        consume(cell.text);
+        cell.sequence.store(head + mask + 1, std::memory_order_release);
+        ++head;
+        return true;
+    }
+
+    bool empty() const {
+        return cells[head & mask].sequence.load(std::memory_order_acquire) != head + 1;
+    }
+};
+
+// Бинарный лог: вместо готового текста пишутся номер формата и сырые байты аргументов,
+// текст восстанавливается потом командой --decode.
+// Файл состоит из сеансов: BINARY_LOG_MAGIC, u32 версия, u32 резерв, затем записи
+//   'D' u32 id, u32 длина, строка формата, u32 длина, типы аргументов
+//   'R' u32 id, u32 длина остатка, i64 секунды, u32 наносекунды, u8 уровень, аргументы
+// (в версии 1 уровня нет, такие записи читаются как Info). Описание формата ('D') пишется перед первой записью с этим id в сеансе.
+// Типы: b bool, c char, i/I int32/int64, u/U uint32/uint64, f double, s u32 длина + байты
+
+constexpr char BINARY_LOG_MAGIC[8] = { 'G', 'A', 'M', 'E', 'L', 'O', 'G', '\0' };
+constexpr std::uint32_t BINARY_LOG_VERSION = 2;
+
+enum class LogEncoding {
+    Text,
+    Binary
+};
+
+// Уровни важности сообщений
+enum class LogLevel : std::uint8_t {
+    Trace,
+    Debug,
+    Info,
+    Warn,
+    Error,
+    Fatal,
+    Off
+};
+
+// Сообщения ниже этого уровня не компилируются совсем.
+// По умолчанию в отладочной сборке остаётся всё, в релизной (NDEBUG) - начиная с Info.
+#ifndef LOG_COMPILE_LEVEL
+#ifdef NDEBUG
+#define LOG_COMPILE_LEVEL 2
+#else
+#define LOG_COMPILE_LEVEL 0
+#endif
+#endif
+constexpr LogLevel COMPILE_LOG_LEVEL = static_cast<LogLevel>(LOG_COMPILE_LEVEL);
+
+// Метка уровня в текстовой строке; у Info метки нет, чтобы обычный вывод игры не менялся
+constexpr std::string_view levelTag(LogLevel level) {
+    switch (level) {
+    case LogLevel::Trace: return "[TRACE] ";
+    case LogLevel::Debug: return "[DEBUG] ";
+    case LogLevel::Warn: return "[WARN] ";
+    case LogLevel::Error: return "[ERROR] ";
+    case LogLevel::Fatal: return "[FATAL] ";
+    default: return "";
+    }
+}
+
+// Строка формата как параметр шаблона: logf<"{} attacks {}">(a, b)
+template <size_t N>
+struct FormatString {
+    char text[N]{};
+
+    constexpr FormatString(const char (&s)[N]) {
+        for (size_t i = 0; i < N; ++i) text[i] = s[i];
+    }
+
+    constexpr std::string_view view() const { return std::string_view(text, N - 1); }
+
+    constexpr size_t placeholders() const {
+        size_t count = 0;
+        for (size_t i = 0; i + 2 < N; ++i) {
+            if (text[i] == '{' && text[i + 1] == '}') {
+                ++count;
+                ++i;
+            }
+        }
+        return count;
     }
+};
 
+template <typename A>
+constexpr char logArgType() {
+    using D = std::decay_t<A>;
+    if constexpr (std::is_same_v<D, bool>) return 'b';
+    else if constexpr (std::is_same_v<D, char>) return 'c';
+    else if constexpr (std::is_integral_v<D> && std::is_signed_v<D>) return sizeof(D) <= 4 ? 'i' : 'I';
+    else if constexpr (std::is_integral_v<D>) return sizeof(D) <= 4 ? 'u' : 'U';
+    else if constexpr (std::is_floating_point_v<D>) return 'f';
+    else {
+        static_assert(std::is_convertible_v<const D&, std::string_view>, "Unsupported log argument type");
+        return 's';
+    }
+}
+
+template <typename V>
+void appendRaw(std::string& out, V value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename V>
+void appendNumber(std::string& out, V value) {
+    char buf[32];
+    auto result = std::to_chars(buf, buf + sizeof(buf), value);
+    out.append(buf, result.ptr);
+}
+
+template <typename A>
+void encodeLogArg(std::string& out, const A& arg) {
+    constexpr char type = logArgType<A>();
+    if constexpr (type == 's') {
+        std::string_view text(arg);
+        appendRaw(out, static_cast<std::uint32_t>(text.size()));
+        out.append(text);
+    }
+    else if constexpr (type == 'b') appendRaw(out, static_cast<std::uint8_t>(arg));
+    else if constexpr (type == 'c') out += arg;
+    else if constexpr (type == 'i') appendRaw(out, static_cast<std::int32_t>(arg));
+    else if constexpr (type == 'I') appendRaw(out, static_cast<std::int64_t>(arg));
+    else if constexpr (type == 'u') appendRaw(out, static_cast<std::uint32_t>(arg));
+    else if constexpr (type == 'U') appendRaw(out, static_cast<std::uint64_t>(arg));
+    else appendRaw(out, static_cast<double>(arg));
+}
+
+template <typename A>
+void renderLogArg(std::string& out, const A& arg) {
+    constexpr char type = logArgType<A>();
+    if constexpr (type == 's') out.append(std::string_view(arg));
+    else if constexpr (type == 'b') out.append(arg ? "true" : "false");
+    else if constexpr (type == 'c') out += arg;
+    else if constexpr (type == 'f') appendNumber(out, static_cast<double>(arg));
+    else appendNumber(out, arg);
+}
+
+// Подставляет аргументы вместо {} по порядку
+template <typename... Args>
+void renderLogMessage(std::string& out, std::string_view format, const Args&... args) {
+    [[maybe_unused]] auto next = [&](const auto& arg) {
+        size_t pos = format.find("{}");
+        out.append(format.substr(0, pos));
+        renderLogArg(out, arg);
+        format.remove_prefix(pos + 2);
+    };
+    (next(args), ...);
+    out.append(format);
+}
+
+struct LogFormat {
+    std::string_view text;
+    std::string_view types;
+};
+
+// Номера форматов, которые встречались в этом процессе
+class LogFormatRegistry {
+public:
+    static std::uint32_t add(LogFormat format) {
+        std::lock_guard<std::mutex> lock(mutex());
+        formats().push_back(format);
+        return static_cast<std::uint32_t>(formats().size() - 1);
+    }
+
+    static LogFormat get(std::uint32_t id) {
+        std::lock_guard<std::mutex> lock(mutex());
+        return formats().at(id);
+    }
+
+private:
+    static std::mutex& mutex() {
+        static std::mutex m;
+        return m;
+    }
+
+    static std::vector<LogFormat>& formats() {
+        static std::vector<LogFormat> list;
+        return list;
+    }
+};
+
+template <FormatString Format, typename... Args>
+struct LogFormatId {
+    static constexpr char types[] = { logArgType<Args>()..., '\0' };
+
+    static std::uint32_t get() {
+        static const std::uint32_t id = LogFormatRegistry::add({ Format.view(), std::string_view(types, sizeof...(Args)) });
+        return id;
+    }
+};
+
+template <FormatString Format, typename... Args>
+void encodeLogRecord(std::string& out, LogLevel level, std::int64_t seconds, std::uint32_t nanos, const Args&... args) {
+    out += 'R';
+    appendRaw(out, LogFormatId<Format, std::decay_t<Args>...>::get());
+    size_t lengthAt = out.size();
+    appendRaw(out, std::uint32_t(0));
+    appendRaw(out, seconds);
+    appendRaw(out, nanos);
+    appendRaw(out, static_cast<std::uint8_t>(level));
+    (encodeLogArg(out, args), ...);
+    auto length = static_cast<std::uint32_t>(out.size() - lengthAt - sizeof(std::uint32_t));
+    std::memcpy(&out[lengthAt], &length, sizeof(length));
+}
+
+// Приёмники лога. Конструируются от имени файла и кодировки, write() получает готовые
+// пакеты байтов, rotate() перед записью пакета может начать новый файл и вернуть true
+// (тогда бинарный лог начинает в нём новый сеанс), flush() сбрасывает буферы на диск.
+// NullSink отключает лог при компиляции.
+
+class NullSink {
 public:
-    Logger(const std::string& filename) {
-        logFile.open(filename, std::ios::app);
-        if (!logFile) {
+    static constexpr bool enabled = false;
+
+    NullSink(const std::string& = "", LogEncoding = LogEncoding::Text) {}
+
+    LogEncoding getEncoding() const { return LogEncoding::Text; }
+    bool rotate() { return false; }
+    void write(std::string_view) {}
+    void flush() {}
+};
+
+class ConsoleSink {
+public:
+    static constexpr bool enabled = true;
+
+    ConsoleSink(const std::string& = "", LogEncoding encoding = LogEncoding::Text) {
+        if (encoding == LogEncoding::Binary) {
+            throw std::invalid_argument("Binary log cannot be written to console");
+        }
+    }
+
+    LogEncoding getEncoding() const { return LogEncoding::Text; }
+    bool rotate() { return false; }
+
+    void write(std::string_view data) {
+        std::cout.write(data.data(), static_cast<std::streamsize>(data.size()));
+        std::cout.flush();
+    }
+
+    void flush() {}
+};
+
+// Записи копятся в буфере потока и сбрасываются в файл, когда набралось FLUSH_THRESHOLD
+// байт, по flush() или при закрытии. Синхронный Logger вызывает flush() после каждой записи,
+// асинхронный - когда очередь опустела.
+class FileSink {
+private:
+    static constexpr size_t FLUSH_THRESHOLD = 64 << 10;
+
+    std::ofstream file;
+    LogEncoding encoding;
+    size_t unflushed = 0;
+
+public:
+    static constexpr bool enabled = true;
+
+    FileSink(const std::string& filename, LogEncoding encoding = LogEncoding::Text) : encoding(encoding) {
+        file.open(filename, encoding == LogEncoding::Binary ? std::ios::app | std::ios::binary : std::ios::app);
+        if (!file) {
             throw std::runtime_error("Cannot open log file");
         }
     }
 
+    LogEncoding getEncoding() const { return encoding; }
+    bool rotate() { return false; }
+
+    void write(std::string_view data) {
+        file.write(data.data(), static_cast<std::streamsize>(data.size()));
+        unflushed += data.size();
+        if (unflushed >= FLUSH_THRESHOLD) flush();
+    }
+
+    void flush() {
+        file.flush();
+        unflushed = 0;
+    }
+};
+
+// Файл и консоль - поведение Logger по умолчанию; бинарный лог пишется только в файл
+class ConsoleFileSink {
+private:
+    FileSink file;
+
+public:
+    static constexpr bool enabled = true;
+
+    ConsoleFileSink(const std::string& filename, LogEncoding encoding = LogEncoding::Text)
+        : file(filename, encoding) {}
+
+    LogEncoding getEncoding() const { return file.getEncoding(); }
+    bool rotate() { return false; }
+
+    void write(std::string_view data) {
+        file.write(data);
+        if (file.getEncoding() == LogEncoding::Text) {
+            std::cout.write(data.data(), static_cast<std::streamsize>(data.size()));
+            std::cout.flush();
+        }
+    }
+
+    void flush() { file.flush(); }
+};
+
+// Сжатие закрытых сегментов лога: блоки по LZ4-схеме (токен с длинами литералов и
+// совпадения, литералы, смещение u16, продолжения длин байтами по 255).
+// Файл: LOG_ARCHIVE_MAGIC, затем блоки u32 исходный размер, u32 сжатый размер, данные;
+// если сжатие не помогло, блок хранится как есть (сжатый размер равен исходному).
+
+constexpr char LOG_ARCHIVE_MAGIC[4] = { 'G', 'L', 'Z', '1' };
+constexpr size_t LOG_ARCHIVE_BLOCK = 1 << 20;
+
+inline std::uint32_t load32(const char* p) {
+    std::uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline void appendLength(std::string& out, size_t length) {
+    for (; length >= 255; length -= 255) out += static_cast<char>(255);
+    out += static_cast<char>(length);
+}
+
+inline void compressBlock(std::string_view in, std::string& out) {
+    constexpr int HASH_BITS = 14;
+    constexpr size_t MIN_MATCH = 4;
+    std::vector<std::uint32_t> table(size_t(1) << HASH_BITS, 0);  // позиция + 1, 0 - пусто
+
+    size_t anchor = 0;
+    auto emit = [&](size_t literalEnd, size_t offset, size_t matchLength) {
+        size_t literals = literalEnd - anchor;
+        size_t matchCode = matchLength ? matchLength - MIN_MATCH : 0;
+        out += static_cast<char>((std::min<size_t>(literals, 15) << 4) | std::min<size_t>(matchCode, 15));
+        if (literals >= 15) appendLength(out, literals - 15);
+        out.append(in.substr(anchor, literals));
+        if (matchLength == 0) return;
+        out += static_cast<char>(offset & 0xFF);
+        out += static_cast<char>(offset >> 8);
+        if (matchCode >= 15) appendLength(out, matchCode - 15);
+    };
+
+    size_t i = 0;
+    while (i + MIN_MATCH <= in.size()) {
+        std::uint32_t sequence = load32(in.data() + i);
+        std::uint32_t hash = (sequence * 2654435761u) >> (32 - HASH_BITS);
+        size_t candidate = table[hash];
+        table[hash] = static_cast<std::uint32_t>(i + 1);
+        if (candidate == 0 || i - (candidate - 1) > 0xFFFF || load32(in.data() + candidate - 1) != sequence) {
+            ++i;
+            continue;
+        }
+
+        size_t match = candidate - 1;
+        size_t length = MIN_MATCH;
+        while (i + length < in.size() && in[match + length] == in[i + length]) ++length;
+        emit(i, i - match, length);
+        i += length;
+        anchor = i;
+    }
+    emit(in.size(), 0, 0);
+}
+
+inline void decompressBlock(std::string_view in, size_t rawSize, std::string& out) {
+    size_t start = out.size();
+    size_t pos = 0;
+    auto corrupt = [] { throw std::runtime_error("Corrupt compressed log"); };
+    auto readLength = [&](size_t length) {
+        if (length != 15) return length;
+        for (;;) {
+            if (pos >= in.size()) corrupt();
+            auto byte = static_cast<unsigned char>(in[pos++]);
+            length += byte;
+            if (byte != 255) return length;
+        }
+    };
+
+    while (pos < in.size()) {
+        auto token = static_cast<unsigned char>(in[pos++]);
+        size_t literals = readLength(token >> 4);
+        if (in.size() - pos < literals) corrupt();
+        out.append(in.substr(pos, literals));
+        pos += literals;
+        if (pos == in.size()) break;
+
+        if (in.size() - pos < 2) corrupt();
+        size_t offset = static_cast<unsigned char>(in[pos]) | (static_cast<unsigned char>(in[pos + 1]) << 8);
+        pos += 2;
+        size_t length = readLength(token & 15) + 4;
+        if (offset == 0 || offset > out.size() - start) corrupt();
+        size_t from = out.size() - offset;
+        for (size_t k = 0; k < length; ++k) out += out[from + k];
+    }
+    if (out.size() - start != rawSize) corrupt();
+}
+
+inline std::string compressLog(std::string_view data) {
+    std::string out(LOG_ARCHIVE_MAGIC, sizeof(LOG_ARCHIVE_MAGIC));
+    std::string packed;
+    for (size_t offset = 0; offset < data.size(); offset += LOG_ARCHIVE_BLOCK) {
+        std::string_view block = data.substr(offset, LOG_ARCHIVE_BLOCK);
+        packed.clear();
+        compressBlock(block, packed);
+        bool stored = packed.size() >= block.size();
+        appendRaw(out, static_cast<std::uint32_t>(block.size()));
+        appendRaw(out, static_cast<std::uint32_t>(stored ? block.size() : packed.size()));
+        out.append(stored ? block : std::string_view(packed));
+    }
+    return out;
+}
+
+inline bool isCompressedLog(std::string_view data) {
+    return data.substr(0, sizeof(LOG_ARCHIVE_MAGIC)) == std::string_view(LOG_ARCHIVE_MAGIC, sizeof(LOG_ARCHIVE_MAGIC));
+}
+
+inline std::string decompressLog(std::string_view data) {
+    if (!isCompressedLog(data)) throw std::runtime_error("Not a compressed log");
+    data.remove_prefix(sizeof(LOG_ARCHIVE_MAGIC));
+    std::string out;
+    while (!data.empty()) {
+        if (data.size() < 8) throw std::runtime_error("Corrupt compressed log");
+        std::uint32_t rawSize = load32(data.data());
+        std::uint32_t packedSize = load32(data.data() + 4);
+        data.remove_prefix(8);
+        if (data.size() < packedSize) throw std::runtime_error("Corrupt compressed log");
+        if (packedSize == rawSize) out.append(data.substr(0, rawSize));
+        else decompressBlock(data.substr(0, packedSize), rawSize, out);
+        data.remove_prefix(packedSize);
+    }
+    return out;
+}
+
+inline std::string readWholeFile(const std::string& filename) {
+    std::ifstream in(filename, std::ios::binary);
+    if (!in) throw std::runtime_error("Cannot open log file");
+    return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+}
+
+// Ротация и хранение лога
+struct RotationOptions {
+    size_t maxBytes = 10 << 20;            // новый сегмент после стольких байт
+    std::chrono::seconds maxAge{ 0 };      // и/или после такого времени, 0 - без ограничения
+    size_t maxFiles = 5;                   // сколько закрытых сегментов хранить
+    std::uintmax_t maxTotalBytes = 0;      // общий объём закрытых сегментов, 0 - без ограничения
+    bool compress = true;                  // сжимать закрытые сегменты в фоне
+};
+
+// Закрытый сегмент лога: <файл>.<номер> или сжатый <файл>.<номер>.lz
+struct LogSegment {
+    std::uint64_t number;
+    std::filesystem::path path;
+    bool compressed;
+};
+
+// Сегменты лога filename по возрастанию номера
+inline std::vector<LogSegment> listLogSegments(const std::string& filename) {
+    std::filesystem::path base(filename);
+    std::filesystem::path dir = base.has_parent_path() ? base.parent_path() : std::filesystem::path(".");
+    std::string prefix = base.filename().string() + ".";
+
+    std::vector<LogSegment> segments;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(dir, ec)) {
+        std::string name = entry.path().filename().string();
+        if (name.compare(0, prefix.size(), prefix) != 0) continue;
+        std::string_view rest = std::string_view(name).substr(prefix.size());
+        bool compressed = rest.size() > 3 && rest.substr(rest.size() - 3) == ".lz";
+        if (compressed) rest.remove_suffix(3);
+
+        std::uint64_t number = 0;
+        auto [end, err] = std::from_chars(rest.data(), rest.data() + rest.size(), number);
+        if (err != std::errc() || end != rest.data() + rest.size() || rest.empty()) continue;
+        segments.push_back({ number, entry.path(), compressed });
+    }
+    std::sort(segments.begin(), segments.end(),
+        [](const LogSegment& a, const LogSegment& b) { return a.number < b.number; });
+    return segments;
+}
+
+// Фоновый поток: сжимает закрытые сегменты и удаляет старые по политике хранения
+class LogArchiver {
+private:
+    std::string filename;
+    RotationOptions options;
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<std::filesystem::path> jobs;
+    bool stopping = false;
+    std::thread worker;
+
+    void compressSegment(const std::filesystem::path& path) {
+        if (!std::filesystem::exists(path)) return;
+        std::string packed = compressLog(readWholeFile(path.string()));
+        std::filesystem::path target = path.string() + ".lz";
+        std::filesystem::path tmp = target.string() + ".tmp";
+        {
+            std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+            out.write(packed.data(), static_cast<std::streamsize>(packed.size()));
+            if (!out) throw std::runtime_error("Cannot write compressed log");
+        }
+        std::filesystem::rename(tmp, target);
+        std::filesystem::remove(path);
+    }
+
+    void applyRetention() {
+        auto segments = listLogSegments(filename);
+        std::uintmax_t total = 0;
+        std::vector<std::uintmax_t> sizes;
+        for (const auto& segment : segments) {
+            std::error_code ec;
+            auto size = std::filesystem::file_size(segment.path, ec);
+            sizes.push_back(ec ? 0 : size);
+            total += sizes.back();
+        }
+
+        // Сегмент, который ещё ждёт сжатия, и его сжатая копия могут лежать рядом
+        size_t count = 0;
+        for (size_t i = 0; i < segments.size(); ++i) {
+            if (i == 0 || segments[i].number != segments[i - 1].number) ++count;
+        }
+        for (size_t i = 0; i < segments.size(); ++i) {
+            bool tooMany = count > options.maxFiles;
+            bool tooBig = options.maxTotalBytes > 0 && total > options.maxTotalBytes;
+            if (!tooMany && !tooBig) break;
+            std::error_code ec;
+            std::filesystem::remove(segments[i].path, ec);
+            total -= sizes[i];
+            if (i + 1 == segments.size() || segments[i + 1].number != segments[i].number) --count;
+        }
+    }
+
+    void run() {
+        for (;;) {
+            std::filesystem::path path;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                ready.wait(lock, [&] { return stopping || !jobs.empty(); });
+                if (jobs.empty()) return;
+                path = std::move(jobs.front());
+                jobs.pop_front();
+            }
+            try {
+                if (options.compress) compressSegment(path);
+                applyRetention();
+            }
+            catch (const std::exception& e) {
+                std::cerr << "Log archive error: " << e.what() << std::endl;
+            }
+        }
+    }
+
+public:
+    LogArchiver(const std::string& filename, const RotationOptions& options)
+        : filename(filename), options(options), worker(&LogArchiver::run, this) {}
+
+    // Дожидается обработки всех сегментов
+    ~LogArchiver() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        ready.notify_one();
+        worker.join();
+    }
+
+    void submit(std::filesystem::path path) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.push_back(std::move(path));
+        }
+        ready.notify_one();
+    }
+};
+
+// Файл с ротацией по размеру и/или времени. Текущий файл переименовывается в
+// <файл>.<номер> и сразу открывается новый, так что запись не ждёт: сжатие и
+// удаление старых сегментов идут в потоке LogArchiver.
+// Файл сменяется перед первым пакетом после того, как набралось maxBytes или прошло maxAge.
+// Если переименовать не удалось, запись продолжается в текущий файл, а следующая попытка
+// будет через ещё один интервал.
+class RotatingFileSink {
+private:
+    std::string filename;
+    LogEncoding encoding;
+    RotationOptions options;
+    std::unique_ptr<FileSink> file;
+    size_t written = 0;
+    std::chrono::steady_clock::time_point openedAt;
+    std::uint64_t nextSegment = 1;
+    std::unique_ptr<LogArchiver> archiver;
+
+    void open() {
+        file = std::make_unique<FileSink>(filename, encoding);
+        std::error_code ec;
+        auto size = std::filesystem::file_size(filename, ec);
+        written = ec ? 0 : static_cast<size_t>(size);
+        openedAt = std::chrono::steady_clock::now();
+    }
+
+public:
+    static constexpr bool enabled = true;
+
+    RotatingFileSink(const std::string& filename, LogEncoding encoding = LogEncoding::Text,
+        const RotationOptions& options = RotationOptions())
+        : filename(filename), encoding(encoding), options(options) {
+        this->options.maxFiles = std::max<size_t>(this->options.maxFiles, 1);
+        archiver = std::make_unique<LogArchiver>(filename, this->options);
+
+        // Сегменты, которые не успели сжать до перезапуска
+        for (const auto& segment : listLogSegments(filename)) {
+            nextSegment = std::max(nextSegment, segment.number + 1);
+            if (!segment.compressed && this->options.compress) archiver->submit(segment.path);
+        }
+        open();
+    }
+
+    LogEncoding getEncoding() const { return encoding; }
+
+    bool rotate() {
+        // Прошлая ротация переименовала файл, но не смогла открыть новый
+        if (!file) {
+            open();
+            return true;
+        }
+
+        bool full = written >= options.maxBytes;
+        bool old = options.maxAge.count() > 0 && written > 0 &&
+            std::chrono::steady_clock::now() - openedAt >= options.maxAge;
+        if (!full && !old) return false;
+
+        file.reset();
+        std::filesystem::path segment = filename + "." + std::to_string(nextSegment);
+        std::error_code ec;
+        std::filesystem::rename(filename, segment, ec);
+        open();
+        if (ec) {
+            written = 0;
+            throw std::filesystem::filesystem_error("Cannot rotate log file", filename, segment, ec);
+        }
+        ++nextSegment;
+        archiver->submit(std::move(segment));
+        return true;
+    }
+
+    void write(std::string_view data) {
+        if (!file) {
+            throw std::runtime_error("Log file is not open");
+        }
+        file->write(data);
+        written += data.size();
+    }
+
+    void flush() {
+        if (file) file->flush();
+    }
+};
+
+// Шаблонный класс Logger.
+// Sink - куда пишется лог, MinLevel - сообщения ниже него не компилируются.
+template <typename T = std::string, typename Sink = ConsoleFileSink, LogLevel MinLevel = COMPILE_LOG_LEVEL>
+class Logger {
+private:
+    LogEncoding encoding;
+    Sink sink;
+    std::atomic<LogLevel> minLevel{ LogLevel::Trace };
+
+    // Асинхронный режим: очередь и фоновый поток записи
+    std::unique_ptr<MpscRingBuffer> queue;
+    AsyncOptions options;
+    std::thread writer;
+    std::atomic<bool> stopping{ false };
+    std::atomic<bool> writerSleeping{ false };
+    std::atomic<uint32_t> wakeups{ 0 };
+    std::atomic<size_t> dropped{ 0 };
+    std::atomic<size_t> overflowed{ 0 };
+    // OverflowPolicy::Block: производители ждут на freed, пока фоновый поток не освободит место
+    std::atomic<uint32_t> freed{ 0 };
+    std::atomic<size_t> blocked{ 0 };
+
+    // Бинарный режим: какие форматы уже описаны в файле (только пишущий поток)
+    std::vector<bool> defined;
+    std::string record;
+    // Синхронный режим: пакет из одной записи, память переиспользуется между вызовами
+    std::string single;
+
+    // Формат отметок времени; менять до начала записи в лог
+    int timestampDigits = 0;
+    Timestamp::Clock timestampClock = Timestamp::Clock::System;
+
+    std::string getCurrentTime() {
+        return Timestamp::format(timestampDigits, timestampClock);
+    }
+
+    template <typename Fill>
+    bool push(Fill&& fill) {
+        bool pushed = queue->tryPush(fill);
+        if (!pushed) {
+            bool keep = options.overflow == OverflowPolicy::Block ||
+                (options.overflow == OverflowPolicy::Sample &&
+                    overflowed.fetch_add(1, std::memory_order_relaxed) % options.sampleRate == 0);
+            if (!keep) {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            waitForSpace(fill);
+        }
+        wakeWriter();
+        return true;
+    }
+
+    template <typename Fill>
+    void waitForSpace(Fill& fill) {
+        for (;;) {
+            uint32_t epoch = freed.load(std::memory_order_acquire);
+            blocked.fetch_add(1);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            bool pushed;
+            try {
+                pushed = queue->tryPush(fill);
+            }
+            catch (...) {
+                blocked.fetch_sub(1);
+                throw;
+            }
+            if (!pushed) {
+                wakeWriter();
+                freed.wait(epoch);
+            }
+            blocked.fetch_sub(1);
+            if (pushed) return;
+        }
+    }
+
+    // Будит производителей, ждущих места; вызывает фоновый поток после разбора очереди
+    void releaseBlocked() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (blocked.load(std::memory_order_relaxed) > 0) {
+            freed.fetch_add(1, std::memory_order_release);
+            freed.notify_all();
+        }
+    }
+
+    void wakeWriter() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (writerSleeping.load(std::memory_order_relaxed) && writerSleeping.exchange(false)) {
+            wakeups.fetch_add(1, std::memory_order_release);
+            wakeups.notify_one();
+        }
+    }
+
+    // Текстовая строка: отметка времени, метка уровня, сообщение от render(std::string&), перевод строки
+    template <typename Render>
+    void emitText(LogLevel level, Render&& render) {
+        char time[Timestamp::MAX_LENGTH];
+        size_t timeLength = Timestamp::format(time, timestampDigits, timestampClock);
+        auto fill = [&](std::string& text) {
+            text.append(time, timeLength);
+            text += ' ';
+            text += levelTag(level);
+            render(text);
+            text += '\n';
+        };
+        if (queue) {
+            push(fill);
+            return;
+        }
+
+        single.clear();
+        fill(single);
+        writeBatch(single);
+        sink.flush();
+    }
+
+    template <FormatString Format, typename... Args>
+    void emitBinary(LogLevel level, const Args&... args) {
+        std::int64_t seconds;
+        std::uint32_t nanos;
+        Timestamp::now(timestampClock, seconds, nanos);
+        auto fill = [&](std::string& out) { encodeLogRecord<Format>(out, level, seconds, nanos, args...); };
+        if (queue) {
+            push(fill);
+            return;
+        }
+
+        record.clear();
+        fill(record);
+        single.clear();
+        appendRecord(single, record);
+        writeBatch(single);
+        sink.flush();
+    }
+
+    template <LogLevel Level, FormatString Format, typename... Args>
+    void write(const Args&... args) {
+        static_assert(Format.placeholders() == sizeof...(Args), "Format placeholders do not match arguments");
+        if constexpr (Sink::enabled && Level >= MinLevel) {
+            if (Level < minLevel.load(std::memory_order_relaxed)) return;
+            if (encoding == LogEncoding::Binary) emitBinary<Format>(Level, args...);
+            else emitText(Level, [&](std::string& text) { renderLogMessage(text, Format.view(), args...); });
+        }
+    }
+
+    void appendDefinition(std::string& out, std::uint32_t id) {
+        LogFormat format = LogFormatRegistry::get(id);
+        out += 'D';
+        appendRaw(out, id);
+        appendRaw(out, static_cast<std::uint32_t>(format.text.size()));
+        out.append(format.text);
+        appendRaw(out, static_cast<std::uint32_t>(format.types.size()));
+        out.append(format.types);
+    }
+
+    // Дописывает бинарную запись в пакет, перед ней - описание формата, если его ещё не было
+    void appendRecord(std::string& batch, const std::string& rec) {
+        std::uint32_t id;
+        std::memcpy(&id, rec.data() + 1, sizeof(id));
+        if (id >= defined.size()) defined.resize(id + 1);
+        if (!defined[id]) {
+            appendDefinition(batch, id);
+            defined[id] = true;
+        }
+        batch += rec;
+    }
+
+    // Заголовок сеанса бинарного лога и описания всех уже использованных форматов
+    void writeSessionHeader() {
+        std::string header(BINARY_LOG_MAGIC, sizeof(BINARY_LOG_MAGIC));
+        appendRaw(header, BINARY_LOG_VERSION);
+        appendRaw(header, std::uint32_t(0));
+        for (std::uint32_t id = 0; id < defined.size(); ++id) {
+            if (defined[id]) appendDefinition(header, id);
+        }
+        sink.write(header);
+    }
+
+    // Ошибка ротации не теряет пакет: о ней пишется в std::cerr, пакет уходит в текущий файл
+    void writeBatch(const std::string& batch) {
+        bool rotated = false;
+        try {
+            rotated = sink.rotate();
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Log rotation failed: " << e.what() << '\n';
+        }
+        if (rotated && encoding == LogEncoding::Binary) {
+            writeSessionHeader();
+        }
+        sink.write(batch);
+    }
+
+    // Фоновый поток: собирает записи в пакеты и пишет их одним вызовом, спит, пока очередь пуста.
+    // Исключение из приёмника не должно завершать программу: пакет теряется, поток работает дальше.
+    // Буферы приёмника сбрасываются, когда очередь опустела и поток собирается спать.
+    void writerLoop() {
+        std::string batch;
+        batch.reserve(options.maxBatch + 256);
+        auto consume = [&](const std::string& rec) {
+            if (rec.empty()) return;  // запись, при заполнении которой было исключение
+            if (encoding == LogEncoding::Binary) appendRecord(batch, rec);
+            else batch += rec;
+        };
+        for (;;) {
+            while (batch.size() < options.maxBatch && queue->tryPop(consume)) {}
+            releaseBlocked();
+
+            size_t lost = dropped.exchange(0, std::memory_order_relaxed);
+            if (lost > 0) {
+                std::string note;
+                if (encoding == LogEncoding::Binary) {
+                    std::int64_t seconds;
+                    std::uint32_t nanos;
+                    Timestamp::now(timestampClock, seconds, nanos);
+                    encodeLogRecord<"[{} log records dropped]">(note, LogLevel::Warn, seconds, nanos, lost);
+                }
+                else {
+                    note = getCurrentTime() + " " + std::string(levelTag(LogLevel::Warn)) +
+                        "[" + std::to_string(lost) + " log records dropped]\n";
+                }
+                consume(note);
+            }
+            if (!batch.empty()) {
+                try {
+                    writeBatch(batch);
+                }
+                catch (const std::exception& e) {
+                    std::cerr << "Log write failed: " << e.what() << '\n';
+                }
+                batch.clear();
+                continue;
+            }
+
+            try {
+                sink.flush();
+            }
+            catch (const std::exception& e) {
+                std::cerr << "Log flush failed: " << e.what() << '\n';
+            }
+            if (stopping.load(std::memory_order_acquire) && queue->empty()) break;
+
+            uint32_t epoch = wakeups.load(std::memory_order_acquire);
+            writerSleeping.store(true);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (queue->empty() && !stopping.load()) {
+                wakeups.wait(epoch);
+            }
+            writerSleeping.store(false);
+        }
+    }
+
+    void startWriter(const AsyncOptions& async) {
+        queue = std::make_unique<MpscRingBuffer>(async.capacity);
+        options = async;
+        options.sampleRate = std::max<size_t>(options.sampleRate, 1);
+        writer = std::thread(&Logger::writerLoop, this);
+    }
+
+public:
+    // В бинарном режиме файл открывается как двоичный и начинается новый сеанс;
+    // на консоль бинарный лог не выводится
+    Logger(const std::string& filename, LogEncoding encoding = LogEncoding::Text)
+        : Logger(Sink(filename, encoding)) {}
+
+    // Готовый приёмник, например RotatingFileSink с нужными лимитами
+    explicit Logger(Sink&& sink) : encoding(sink.getEncoding()), sink(std::move(sink)) {
+        if (encoding == LogEncoding::Binary) writeSessionHeader();
+    }
+
+    // Асинхронный режим: log() только кладёт запись в очередь, в приёмник
+    // пишет фоновый поток. Оставшиеся записи дописываются в деструкторе.
+    Logger(const std::string& filename, const AsyncOptions& async, LogEncoding encoding = LogEncoding::Text)
+        : Logger(filename, encoding) {
+        startWriter(async);
+    }
+
+    Logger(Sink&& sink, const AsyncOptions& async) : Logger(std::move(sink)) {
+        startWriter(async);
+    }
+
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
     ~Logger() {
-        if (logFile.is_open()) logFile.close();
+        if (writer.joinable()) {
+            stopping.store(true, std::memory_order_release);
+            wakeups.fetch_add(1, std::memory_order_release);
+            wakeups.notify_one();
+            writer.join();
+        }
     }
 
+    bool isAsync() const { return queue != nullptr; }
+
+    // digits знаков после секунд (0..9) и источник времени для отметок
+    void setTimestampFormat(int digits, Timestamp::Clock clock = Timestamp::Clock::System) {
+        timestampDigits = std::clamp(digits, 0, 9);
+        timestampClock = clock;
+    }
+
+    // Уровень, ниже которого сообщения отбрасываются во время работы
+    void setLevel(LogLevel level) { minLevel.store(level, std::memory_order_relaxed); }
+    LogLevel getLevel() const { return minLevel.load(std::memory_order_relaxed); }
+
     void log(const T& message) {
-        std::ostringstream oss;
-        oss << getCurrentTime() << " " << message;
-        std::cout << oss.str() << std::endl;
-        logFile << oss.str() << std::endl;
-        logFile.flush();
+        log(LogLevel::Info, message);
+    }
+
+    void log(LogLevel level, const T& message) {
+        if constexpr (Sink::enabled) {
+            if (level < MinLevel || level < minLevel.load(std::memory_order_relaxed)) return;
+            if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+                if (encoding == LogEncoding::Binary) emitBinary<"{}">(level, std::string_view(message));
+                else emitText(level, [&](std::string& text) { text += std::string_view(message); });
+            }
+            else {
+                std::ostringstream oss;
+                oss << message;
+                if (encoding == LogEncoding::Binary) emitBinary<"{}">(level, oss.str());
+                else emitText(level, [&](std::string& text) { text += oss.str(); });
+            }
+        }
     }
+
+    // Сообщения по формату времени компиляции: аргументы подставляются вместо {}.
+    // В бинарном режиме сохраняются только номер формата и байты аргументов.
+    // logf пишет с уровнем Info.
+    template <FormatString Format, typename... Args>
+    void logf(const Args&... args) { write<LogLevel::Info, Format>(args...); }
+
+    template <FormatString Format, typename... Args>
+    void trace(const Args&... args) { write<LogLevel::Trace, Format>(args...); }
+
+    template <FormatString Format, typename... Args>
+    void debug(const Args&... args) { write<LogLevel::Debug, Format>(args...); }
+
+    template <FormatString Format, typename... Args>
+    void info(const Args&... args) { write<LogLevel::Info, Format>(args...); }
+
+    template <FormatString Format, typename... Args>
+    void warn(const Args&... args) { write<LogLevel::Warn, Format>(args...); }
+
+    template <FormatString Format, typename... Args>
+    void error(const Args&... args) { write<LogLevel::Error, Format>(args...); }
+
+    template <FormatString Format, typename... Args>
+    void fatal(const Args&... args) { write<LogLevel::Fatal, Format>(args...); }
 };
 
+// Перевод бинарного лога (или сжатого сегмента бинарного лога) в текст, в том же виде, что и текстовый лог
+void decodeBinaryLog(const std::string& filename, int digits, std::ostream& out) {
+    std::string data = readWholeFile(filename);
+    if (isCompressedLog(data)) data = decompressLog(data);
+
+    std::string_view rest(data);
+    auto take = [&](size_t size) {
+        if (rest.size() < size) throw std::runtime_error("Truncated binary log");
+        std::string_view bytes = rest.substr(0, size);
+        rest.remove_prefix(size);
+        return bytes;
+    };
+    auto read = [&](auto value) {
+        std::memcpy(&value, take(sizeof(value)).data(), sizeof(value));
+        return value;
+    };
+
+    std::unordered_map<std::uint32_t, std::pair<std::string, std::string>> formats;
+    std::uint32_t version = BINARY_LOG_VERSION;
+    std::string line;
+    char time[Timestamp::MAX_LENGTH];
+    while (!rest.empty()) {
+        if (rest.substr(0, sizeof(BINARY_LOG_MAGIC)) == std::string_view(BINARY_LOG_MAGIC, sizeof(BINARY_LOG_MAGIC))) {
+            take(sizeof(BINARY_LOG_MAGIC));
+            version = read(std::uint32_t(0));
+            if (version < 1 || version > BINARY_LOG_VERSION) throw std::runtime_error("Unsupported binary log version");
+            read(std::uint32_t(0));
+            formats.clear();
+            continue;
+        }
+
+        char kind = take(1)[0];
+        std::uint32_t id = read(std::uint32_t(0));
+        if (kind == 'D') {
+            std::string text(take(read(std::uint32_t(0))));
+            std::string types(take(read(std::uint32_t(0))));
+            formats[id] = { std::move(text), std::move(types) };
+            continue;
+        }
+        if (kind != 'R') throw std::runtime_error("Corrupt binary log");
+
+        auto it = formats.find(id);
+        if (it == formats.end()) throw std::runtime_error("Unknown log format id");
+        std::string_view payload = take(read(std::uint32_t(0)));
+        std::swap(rest, payload);
+        std::int64_t seconds = read(std::int64_t(0));
+        std::uint32_t nanos = read(std::uint32_t(0));
+        auto level = version >= 2 ? static_cast<LogLevel>(read(std::uint8_t(0))) : LogLevel::Info;
+
+        line.assign(time, Timestamp::format(time, digits, seconds, nanos));
+        line += ' ';
+        line += levelTag(level);
+        std::string_view format = it->second.first;
+        for (char type : it->second.second) {
+            size_t pos = format.find("{}");
+            line.append(format.substr(0, pos));
+            format.remove_prefix(pos + 2);
+            switch (type) {
+            case 'b': line.append(read(std::uint8_t(0)) ? "true" : "false"); break;
+            case 'c': line += take(1)[0]; break;
+            case 'i': appendNumber(line, read(std::int32_t(0))); break;
+            case 'I': appendNumber(line, read(std::int64_t(0))); break;
+            case 'u': appendNumber(line, read(std::uint32_t(0))); break;
+            case 'U': appendNumber(line, read(std::uint64_t(0))); break;
+            case 'f': appendNumber(line, read(double(0))); break;
+            case 's': line.append(take(read(std::uint32_t(0)))); break;
+            default: throw std::runtime_error("Corrupt binary log");
+            }
+        }
+        line.append(format);
+        out << line << '\n';
+        std::swap(rest, payload);
+    }
+}
+
 // Инвентарь
 class Inventory {
 private:
@@ -88,10 +1319,20 @@ protected:
     Inventory inventory;
 
 public:
+    // Изменяемые в бою характеристики - чтобы повторять бой с одного и того же состояния
+    struct Stats {
+        int health;
+        int maxHealth;
+        int attack;
+        int defense;
+        int level;
+        int experience;
+    };
+
     Character(const std::string& n, int h, int a, int d, Logger<>& logger)
         : name(n), health(h), maxHealth(h), attack(a), defense(d),
         level(1), experience(0), logger(logger) {
-        logger.log("Character " + name + " created");
+        logger.logf<"Character {} created">(name);
     }
 
     virtual ~Character() = default;
@@ -103,28 +1344,29 @@ public:
         int damage = attack - enemy.getDefense();
         if (damage > 0) {
             enemy.takeDamage(damage);
-            logger.log(name + " attacks " + enemy.getName() + " for " + std::to_string(damage) + " damage");
+            logger.logf<"{} attacks {} for {} damage">(name, enemy.getName(), damage);
 
             if (!enemy.isAlive()) {
-                logger.log(enemy.getName() + " has been killed");
+                logger.logf<"{} has been killed">(enemy.getName());
                 gainExperience(30);
             }
         }
         else {
-            logger.log(name + " attacks " + enemy.getName() + ", but it's ineffective");
+            logger.logf<"{} attacks {}, but it's ineffective">(name, enemy.getName());
         }
     }
 
     void takeDamage(int damage) {
         health -= damage;
         if (health < 0) health = 0;
-        logger.log(name + " takes " + std::to_string(damage) + " damage");
+        logger.logf<"{} takes {} damage">(name, damage);
+        logger.trace<"{} health: {}/{}">(name, health, maxHealth);
     }
 
     void heal(int amount) {
         health += amount;
         if (health > maxHealth) health = maxHealth;
-        logger.log(name + " heals " + std::to_string(amount) + " HP");
+        logger.logf<"{} heals {} HP">(name, amount);
     }
 
     void gainExperience(int exp) {
@@ -136,7 +1378,7 @@ public:
             attack += 5;
             defense += 3;
             health = maxHealth;
-            logger.log(name + " leveled up to " + std::to_string(level));
+            logger.logf<"{} leveled up to {}">(name, level);
         }
     }
 
@@ -148,12 +1390,23 @@ public:
     }
 
     bool isAlive() const { return health > 0; }
-    std::string getName() const { return name; }
+    const std::string& getName() const { return name; }
+
+    Stats getStats() const { return { health, maxHealth, attack, defense, level, experience }; }
+
+    void setStats(const Stats& stats) {
+        health = stats.health;
+        maxHealth = stats.maxHealth;
+        attack = stats.attack;
+        defense = stats.defense;
+        level = stats.level;
+        experience = stats.experience;
+    }
     int getDefense() const { return defense; }
 
     void addItem(const std::string& item) {
         inventory.addItem(item);
-        logger.log(name + " picks up item: " + item);
+        logger.logf<"{} picks up item: {}">(name, item);
     }
 
     void saveGame(const std::string& filename) {
@@ -188,7 +1441,7 @@ public:
         int damage = attack - target.getDefense() + 2;
         if (damage > 0) {
             target.takeDamage(damage);
-            logger.log(name + " uses special attack: " + std::to_string(damage) + " damage");
+            logger.logf<"{} uses special attack: {} damage">(name, damage);
         }
     }
 };
@@ -201,7 +1454,7 @@ public:
         int damage = attack - target.getDefense() + 3;
         if (damage > 0) {
             target.takeDamage(damage);
-            logger.log(name + " uses special attack: " + std::to_string(damage) + " damage");
+            logger.logf<"{} uses special attack: {} damage">(name, damage);
         }
     }
 };
@@ -214,31 +1467,415 @@ public:
         int damage = attack - target.getDefense() + 5;
         if (damage > 0) {
             target.takeDamage(damage);
-            logger.log(name + " breathes fire for " + std::to_string(damage) + " damage");
+            logger.logf<"{} breathes fire for {} damage">(name, damage);
         }
     }
 };
 
+// Темп симуляции боя
+enum class Pacing {
+    RealTime,         // ход происходит, когда до него доходят настоящие часы
+    AsFastAsPossible  // виртуальные часы сразу переводятся к следующему ходу
+};
+
+struct BattleOptions {
+    Pacing pacing = Pacing::RealTime;
+    std::chrono::milliseconds heroInterval{ 1000 };     // время между ходами героя
+    std::chrono::milliseconds monsterInterval{ 1000 };  // время между ходами монстра
+    double speed = 1.0;                                 // ускорение в режиме RealTime
+};
+
+struct BattleResult {
+    bool heroWon;
+    int turns;
+    std::chrono::milliseconds duration;  // по виртуальным часам
+};
+
+// Бой как дискретно-событийная симуляция: ходы - события в очереди по виртуальному
+// времени, при равном времени первым ходит тот, кто был запланирован раньше (герой).
+// Очередь переиспользуется между боями, так что повторный run() не выделяет память.
+class BattleEngine {
+private:
+    enum class Actor : std::uint8_t { Hero, Monster };
+
+    struct Event {
+        std::chrono::milliseconds at;
+        std::uint64_t sequence;
+        Actor actor;
+
+        bool operator>(const Event& other) const {
+            return at != other.at ? at > other.at : sequence > other.sequence;
+        }
+    };
+
+    BattleOptions options;
+    std::vector<Event> events;
+    std::uint64_t nextSequence = 0;
+
+    void schedule(std::chrono::milliseconds at, Actor actor) {
+        events.push_back({ at, nextSequence++, actor });
+        std::push_heap(events.begin(), events.end(), std::greater<Event>());
+    }
+
+public:
+    explicit BattleEngine(const BattleOptions& options = BattleOptions()) : options(options) {
+        if (options.heroInterval.count() <= 0 || options.monsterInterval.count() <= 0 || options.speed <= 0) {
+            throw std::invalid_argument("Battle intervals and speed must be positive");
+        }
+    }
+
+    BattleResult run(Character& hero, Monster& monster) {
+        events.clear();
+        nextSequence = 0;
+        schedule(std::chrono::milliseconds(0), Actor::Hero);
+        schedule(std::chrono::milliseconds(0), Actor::Monster);
+
+        auto wallStart = std::chrono::steady_clock::now();
+        std::chrono::milliseconds now(0);
+        int turns = 0;
+        while (!events.empty() && hero.isAlive() && monster.isAlive()) {
+            std::pop_heap(events.begin(), events.end(), std::greater<Event>());
+            Event event = events.back();
+            events.pop_back();
+            now = event.at;
+
+            if (options.pacing == Pacing::RealTime) {
+                std::this_thread::sleep_until(wallStart + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                    std::chrono::duration<double, std::milli>(now.count() / options.speed)));
+            }
+
+            // Ошибка хода не выбивает участника из боя: следующий ход назначается в любом случае
+            try {
+                if (event.actor == Actor::Hero) hero.attackEnemy(monster);
+                else monster.specialAttack(hero);
+            }
+            catch (const std::exception& e) {
+                std::cerr << "Battle error: " << e.what() << std::endl;
+            }
+            schedule(now + (event.actor == Actor::Hero ? options.heroInterval : options.monsterInterval), event.actor);
+            ++turns;
+        }
+        return { hero.isAlive(), turns, now };
+    }
+};
+
 // Битва
-void battle(Character& hero, Monster& monster) {
-    while (hero.isAlive() && monster.isAlive()) {
-        try {
-            hero.attackEnemy(monster);
-            if (!monster.isAlive()) break;
-            monster.specialAttack(hero);
+void battle(Character& hero, Monster& monster, Pacing pacing = Pacing::RealTime) {
+    BattleOptions options;
+    options.pacing = pacing;
+    BattleEngine(options).run(hero, monster);
+}
+
+// Тренировочные бои без пауз: много сообщений в лог на каждый раунд
+void trainHero(Logger<>& logger, int fights) {
+    Character hero("Trainee", 100, 15, 5, logger);
+    for (int i = 0; i < fights; ++i) {
+        Goblin goblin(logger);
+        while (goblin.isAlive()) {
+            hero.attackEnemy(goblin);
+            if (goblin.isAlive()) goblin.specialAttack(hero);
         }
-        catch (const std::exception& e) {
-            std::cerr << "Battle error: " << e.what() << std::endl;
+        hero.heal(100);
+    }
+}
+
+// Размер лога тренировочных боёв в заданной кодировке
+std::uintmax_t logSize(int fights, LogEncoding encoding) {
+    const char* filename = "bench_size.log";
+    {
+        Logger<> logger(filename, AsyncOptions{}, encoding);
+        trainHero(logger, fights);
+    }
+    std::ifstream in(filename, std::ios::binary | std::ios::ate);
+    auto size = static_cast<std::uintmax_t>(in.tellg());
+    in.close();
+    std::remove(filename);
+    return size;
+}
+
+// Время тренировочных боёв с синхронным и асинхронным, текстовым и бинарным логгером.
+// Сам лог идёт в stdout, поэтому результаты печатаются в stderr: ./a --bench log 2000 > /dev/null
+void benchmarkLogging(int fights) {
+    auto time = [](auto&& action) {
+        auto start = std::chrono::steady_clock::now();
+        action();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    double syncMs = time([&] {
+        Logger<> logger("bench_log.txt");
+        trainHero(logger, fights);
+    });
+    double asyncMs = time([&] {
+        Logger<> logger("bench_log.txt", AsyncOptions{});
+        trainHero(logger, fights);
+    });
+    double callerMs = 0;
+    double drainMs = time([&] {
+        Logger<> logger("bench_log.txt", AsyncOptions{});
+        callerMs = time([&] { trainHero(logger, fights); });
+    });
+
+    const int threads = 4;
+    double threadedMs = time([&] {
+        Logger<> logger("bench_log.txt", AsyncOptions{});
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t) {
+            workers.emplace_back(trainHero, std::ref(logger), fights / threads);
         }
-        std::this_thread::sleep_for(std::chrono::seconds(1));
+        for (auto& w : workers) w.join();
+    });
+    double droppingMs = time([&] {
+        AsyncOptions options;
+        options.overflow = OverflowPolicy::Drop;
+        Logger<> logger("bench_log.txt", options);
+        trainHero(logger, fights);
+    });
+    std::remove("bench_log.txt");
+    auto textBytes = logSize(fights, LogEncoding::Text);
+
+    double binaryMs = time([&] {
+        Logger<> logger("bench_log.bin", LogEncoding::Binary);
+        trainHero(logger, fights);
+    });
+    std::remove("bench_log.bin");
+    double asyncBinaryMs = time([&] {
+        Logger<> logger("bench_log.bin", AsyncOptions{}, LogEncoding::Binary);
+        trainHero(logger, fights);
+    });
+    std::remove("bench_log.bin");
+    auto binaryBytes = logSize(fights, LogEncoding::Binary);
+
+    std::cerr << "fights: " << fights << "\n"
+        << "sync logger: " << syncMs << " ms\n"
+        << "async logger (block): " << asyncMs << " ms, caller side " << callerMs
+        << " ms of " << drainMs << " ms\n"
+        << "async logger, " << threads << " threads: " << threadedMs << " ms\n"
+        << "async logger (drop): " << droppingMs << " ms\n"
+        << "binary logger: " << binaryMs << " ms\n"
+        << "async binary logger: " << asyncBinaryMs << " ms\n"
+        << "log size: text " << textBytes << " bytes, binary " << binaryBytes << " bytes" << std::endl;
+}
+
+// Стоимость одной отметки времени: прежний способ (localtime + strftime на каждую
+// строку) против кэша по секундам с обычными и грубыми часами
+void benchmarkTimestamps(int count) {
+    auto time = [&](auto&& format) {
+        size_t checksum = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < count; ++i) checksum += format().size();
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        [[maybe_unused]] static volatile size_t sink;
+        sink = checksum;
+        return ns / count;
+    };
+
+    double legacy = time([] {
+        auto in_time_t = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+        char buf[80];
+        std::tm tm = localTime(in_time_t);
+        strftime(buf, sizeof(buf), "[%Y-%m-%d %H:%M:%S]", &tm);
+        return std::string(buf);
+    });
+    char buf[Timestamp::MAX_LENGTH];
+    double cached = time([&] { return std::string_view(buf, Timestamp::format(buf, 0)); });
+    double millis = time([&] { return std::string_view(buf, Timestamp::format(buf, 3)); });
+    double coarse = time([&] { return std::string_view(buf, Timestamp::format(buf, 3, Timestamp::Clock::Coarse)); });
+
+    std::cout << "timestamps: " << count << "\n"
+        << "localtime + strftime: " << legacy << " ns\n"
+        << "cached: " << cached << " ns\n"
+        << "cached, milliseconds: " << millis << " ns\n"
+        << "cached, milliseconds, coarse clock: " << coarse << " ns\n"
+        << "sample: " << Timestamp::format(6) << std::endl;
+}
+
+// Стоимость trace-сообщения: записанного в файл, отброшенного по уровню во время работы,
+// вырезанного при компиляции и отправленного в NullSink
+void benchmarkLevels(int count) {
+    auto time = [&](auto& logger) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < count; ++i) {
+            logger.template trace<"{} takes {} damage">(std::string_view("Goblin"), i);
+        }
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / count;
+    };
+
+    double written, filtered, compiledOut, null;
+    {
+        Logger<std::string, FileSink> logger("bench_level.txt");
+        written = time(logger);
+        logger.setLevel(LogLevel::Info);
+        filtered = time(logger);
+    }
+    {
+        Logger<std::string, FileSink, LogLevel::Info> logger("bench_level.txt");
+        compiledOut = time(logger);
+    }
+    {
+        Logger<std::string, NullSink> logger("");
+        null = time(logger);
+    }
+    std::remove("bench_level.txt");
+
+    std::cout << "trace messages: " << count << "\n"
+        << "written to file: " << written << " ns\n"
+        << "filtered at runtime: " << filtered << " ns\n"
+        << "compiled out: " << compiledOut << " ns\n"
+        << "null sink: " << null << " ns" << std::endl;
+}
+
+// Лог с ротацией: время записи, число и объём сегментов до и после сжатия,
+// скорость сжатия и проверка распаковки
+void benchmarkRotation(int lines) {
+    const std::string filename = "bench_rotate.txt";
+    auto cleanup = [&] {
+        std::filesystem::remove(filename);
+        for (const auto& segment : listLogSegments(filename)) std::filesystem::remove(segment.path);
+    };
+    cleanup();
+
+    RotationOptions rotation;
+    rotation.maxBytes = 1 << 20;
+    rotation.maxFiles = 1000;
+    double callerMs = 0;
+    auto start = std::chrono::steady_clock::now();
+    {
+        Logger<std::string, RotatingFileSink> logger(RotatingFileSink(filename, LogEncoding::Text, rotation), AsyncOptions{});
+        auto callerStart = std::chrono::steady_clock::now();
+        for (int i = 0; i < lines; ++i) {
+            logger.logf<"{} attacks {} for {} damage">(std::string_view("Hero"), std::string_view("Goblin"), i % 97);
+        }
+        callerMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - callerStart).count();
+    }
+    double totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    auto segments = listLogSegments(filename);
+    std::uintmax_t packedBytes = 0;
+    for (const auto& segment : segments) packedBytes += std::filesystem::file_size(segment.path);
+
+    std::string sample = segments.empty() ? std::string() : readWholeFile(segments.front().path.string());
+    std::string raw = decompressLog(sample);
+    auto compressStart = std::chrono::steady_clock::now();
+    std::string again = compressLog(raw);
+    double compressMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - compressStart).count();
+    bool roundTrip = again == sample && raw.size() >= rotation.maxBytes;
+
+    std::cout << "lines: " << lines << "\n"
+        << "caller side: " << callerMs << " ms, with drain and archiving: " << totalMs << " ms\n"
+        << "segments: " << segments.size() << ", compressed size: " << packedBytes << " bytes\n"
+        << "segment: " << raw.size() << " -> " << sample.size() << " bytes, compressed in "
+        << compressMs << " ms, round trip " << (roundTrip ? "ok" : "FAILED") << std::endl;
+    cleanup();
+}
+
+// Бои без пауз и с выключенным логом: герой по очереди против гоблина, скелета и дракона,
+// каждый бой с исходных характеристик
+void benchmarkSimulation(int battles) {
+    Logger<> logger("bench_sim.txt");
+    logger.setLevel(LogLevel::Off);
+
+    Character hero("Hero", 100, 15, 5, logger);
+    Goblin goblin(logger);
+    Skeleton skeleton(logger);
+    Dragon dragon(logger);
+    Monster* opponents[] = { &goblin, &skeleton, &dragon };
+    Character::Stats heroStart = hero.getStats();
+    Character::Stats monsterStart[] = { goblin.getStats(), skeleton.getStats(), dragon.getStats() };
+
+    BattleOptions options;
+    options.pacing = Pacing::AsFastAsPossible;
+    BattleEngine engine(options);
+
+    int wins[3] = {};
+    long long turns = 0;
+    long long virtualMs = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < battles; ++i) {
+        int k = i % 3;
+        hero.setStats(heroStart);
+        opponents[k]->setStats(monsterStart[k]);
+        BattleResult result = engine.run(hero, *opponents[k]);
+        wins[k] += result.heroWon;
+        turns += result.turns;
+        virtualMs += result.duration.count();
     }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::remove("bench_sim.txt");
+
+    std::cout << "battles: " << battles << ", turns: " << turns << "\n"
+        << "wall time: " << seconds * 1000 << " ms, " << battles / seconds / 1e6 << " M battles/s\n"
+        << "virtual time: " << virtualMs / 1000 << " s\n"
+        << "hero wins vs Goblin/Skeleton/Dragon: " << wins[0] << "/" << wins[1] << "/" << wins[2] << std::endl;
 }
 
 // Главная функция
-int main() {
+int main(int argc, char* argv[]) {
+    if (argc > 2 && std::string(argv[1]) == "--bench") {
+        try {
+            std::string name = argv[2];
+            if (name == "log") {
+                benchmarkLogging(argc > 3 ? std::stoi(argv[3]) : 2000);
+            }
+            else if (name == "sim") {
+                benchmarkSimulation(argc > 3 ? std::stoi(argv[3]) : 3000000);
+            }
+            else if (name == "rotate") {
+                benchmarkRotation(argc > 3 ? std::stoi(argv[3]) : 1000000);
+            }
+            else if (name == "level") {
+                benchmarkLevels(argc > 3 ? std::stoi(argv[3]) : 1000000);
+            }
+            else if (name == "time") {
+                benchmarkTimestamps(argc > 3 ? std::stoi(argv[3]) : 1000000);
+            }
+            else {
+                std::cerr << "Unknown benchmark: " << name << std::endl;
+                return 1;
+            }
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Fatal Error: " << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+    if (argc > 2 && std::string(argv[1]) == "--decode") {
+        try {
+            decodeBinaryLog(argv[2], argc > 3 ? std::stoi(argv[3]) : 0, std::cout);
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Fatal Error: " << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+    if (argc > 2 && std::string(argv[1]) == "--unpack") {
+        try {
+            std::string data = decompressLog(readWholeFile(argv[2]));
+            std::cout.write(data.data(), static_cast<std::streamsize>(data.size()));
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Fatal Error: " << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+    bool binary = false;
+    bool trace = false;
+    Pacing pacing = Pacing::RealTime;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--binary") binary = true;
+        if (arg == "--fast") pacing = Pacing::AsFastAsPossible;
+        if (arg == "--trace") trace = true;
+    }
+
     try {
-        Logger<> logger("game_log.txt");
-        logger.log("=== Game Started ===");
+        Logger<> logger(binary ? "game_log.bin" : "game_log.txt", binary ? LogEncoding::Binary : LogEncoding::Text);
+        // Трассировка (здоровье после каждого удара) - только с --trace и не в сборке с NDEBUG
+        logger.setLevel(trace ? LogLevel::Trace : LogLevel::Info);
+        logger.logf<"=== Game Started ===">();
 
         Character hero("Hero", 100, 15, 5, logger);
         hero.addItem("Health Potion");
@@ -254,15 +1891,15 @@ int main() {
         monsters.push_back(std::make_unique<Dragon>(logger));
 
         for (auto& monster : monsters) {
-            logger.log("\n--- New Battle ---");
+            logger.logf<"\n--- New Battle ---">();
             hero.displayInfo();
             monster->displayInfo();
             std::cout << std::endl;
 
-            battle(hero, *monster);
+            battle(hero, *monster, pacing);
 
             if (!hero.isAlive()) {
-                logger.log("Hero has fallen!");
+                logger.logf<"Hero has fallen!">();
                 break;
             }
 
@@ -270,10 +1907,10 @@ int main() {
         }
 
         if (hero.isAlive()) {
-            logger.log("Hero defeated all monsters!");
+            logger.logf<"Hero defeated all monsters!">();
         }
 
-        logger.log("=== Game Ended ===");
+        logger.logf<"=== Game Ended ===">();
     }
     catch (const std::exception& e) {
         std::cerr << "Fatal Error: " << e.what() << std::endl;